@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <switch.h>
+
+// Fails the run, so `make run` stops on a wrong result and not only a slow one
+#define BENCH_CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        exit(1); \
+    } \
+} while (0)
+
+#define BENCH_RUNS 5
+
+static inline u64 bench_now_ns() {
+    return armTicksToNs(armGetSystemTick());
+}
+
+// Deterministic, so every run works on the same data
+static inline u32 bench_rand(u32 *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static inline int bench_u64_cmp(const void *a, const void *b) {
+    u64 x = *(const u64 *) a;
+    u64 y = *(const u64 *) b;
+
+    return (x > y) - (x < y);
+}
+
+// Prints the best and median of the runs in microseconds
+static inline void bench_report(const char *name, u64 *ns, int runs) {
+    qsort(ns, runs, sizeof(u64), bench_u64_cmp);
+    printf("%-48s best %8.1fus  median %8.1fus\n", name, ns[0] / 1000.0, ns[runs / 2] / 1000.0);
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "catalog.h"
+
+#define MERGE_BATCH 64
+
+static const char *g_words[] = {
+    "homebrew", "retro", "arch", "Checkpoint", "edizon", "goldleaf", "hb", "Tinfoil",
+    "nx", "shop", "menu", "loader", "emu", "Player", "save", "manager",
+};
+
+#define NUM_WORDS (sizeof(g_words) / sizeof(g_words[0]))
+
+// The catalog's entries would normally come from app_entry_scan
+void app_entry_free(app_entry_t *entry) {
+    free(entry);
+}
+
+lv_res_t app_entry_scan(app_entry_scan_cb_t cb, void *arg) {
+    return LV_RES_INV;
+}
+
+/*
+ * Names built from a handful of words, so plenty of them share the first
+ * seven bytes the sort key holds and have to fall back to strcasecmp.
+ */
+static char *make_names(int num) {
+    char *names = malloc(num * 32);
+    u32 seed = 1;
+
+    for (int i = 0; i < num; i++) {
+        snprintf(&names[i * 32], 32, "%s %s %u", g_words[bench_rand(&seed) % NUM_WORDS], g_words[bench_rand(&seed) % NUM_WORDS], bench_rand(&seed) % 1000);
+    }
+
+    return names;
+}
+
+// A fresh, shuffled set of entries, a tenth of them starred
+static app_entry_t **make_entries(const char *names, int num) {
+    app_entry_t **entries = malloc(num * sizeof(app_entry_t *));
+    u32 seed = 2;
+
+    for (int i = 0; i < num; i++) {
+        app_entry_t *entry = calloc(1, sizeof(app_entry_t));
+
+        entry->path = entry->name = &names[i * 32];
+        entry->author = "";
+        entry->starred = (i % 10) == 0;
+
+        app_entry_update_sort_key(entry);
+
+        entries[i] = entry;
+    }
+
+    for (int i = num - 1; i > 0; i--) {
+        int j = bench_rand(&seed) % (i + 1);
+
+        app_entry_t *tmp = entries[i];
+        entries[i] = entries[j];
+        entries[j] = tmp;
+    }
+
+    return entries;
+}
+
+static void check_sorted(catalog_t *catalog, int num) {
+    BENCH_CHECK(catalog->len == num, "%d entries, expected %d", catalog->len, num);
+
+    for (int i = 1; i < catalog->len; i++)
+        BENCH_CHECK(app_entry_cmp(catalog->entries[i - 1], catalog->entries[i]) <= 0, "out of order at %d", i);
+}
+
+// How catalog_scan builds the list
+static u64 run_sort(app_entry_t **entries, int num) {
+    catalog_t catalog;
+    catalog_init(&catalog);
+
+    for (int i = 0; i < num; i++)
+        catalog_append(&catalog, entries[i]);
+
+    u64 start = bench_now_ns();
+    catalog_sort(&catalog);
+    u64 ns = bench_now_ns() - start;
+
+    check_sorted(&catalog, num);
+    catalog_clear(&catalog);
+
+    return ns;
+}
+
+// How the scan thread's finds reach the list while it's still running
+static u64 run_merge(app_entry_t **entries, int num) {
+    catalog_t catalog;
+    catalog_init(&catalog);
+
+    u64 start = bench_now_ns();
+
+    for (int i = 0; i < num; i += MERGE_BATCH) {
+        int first_changed;
+        int batch = (num - i < MERGE_BATCH) ? num - i : MERGE_BATCH;
+
+        catalog_merge(&catalog, &entries[i], batch, &first_changed);
+    }
+
+    u64 ns = bench_now_ns() - start;
+
+    check_sorted(&catalog, num);
+    catalog_clear(&catalog);
+
+    return ns;
+}
+
+// One entry at a time, like an app sent over the remote loader
+static u64 run_insert(app_entry_t **entries, int num) {
+    catalog_t catalog;
+    catalog_init(&catalog);
+
+    u64 start = bench_now_ns();
+
+    for (int i = 0; i < num; i++)
+        catalog_insert(&catalog, entries[i], NULL);
+
+    u64 ns = bench_now_ns() - start;
+
+    check_sorted(&catalog, num);
+    catalog_clear(&catalog);
+
+    return ns;
+}
+
+int main() {
+    static const int sizes[] = {1000, 10000};
+
+    static const struct {
+        const char *name;
+        u64 (*run)(app_entry_t **entries, int num);
+    } cases[] = {
+        {"append + catalog_sort", run_sort},
+        {"catalog_merge, batches of 64", run_merge},
+        {"catalog_insert", run_insert},
+    };
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int num = sizes[s];
+        char *names = make_names(num);
+
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            u64 ns[BENCH_RUNS];
+
+            // The catalog frees the entries, so every run gets its own
+            for (int r = 0; r < BENCH_RUNS; r++) {
+                app_entry_t **entries = make_entries(names, num);
+                ns[r] = cases[c].run(entries, num);
+                free(entries);
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "%s, %d", cases[c].name, num);
+            bench_report(label, ns, BENCH_RUNS);
+        }
+
+        free(names);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <turbojpeg.h>
+
+#include "bench.h"
+#include "decoder.h"
+#include "icon_store.h"
+#include "settings.h"
+#include "thumbs.h"
+
+#define ICON_PATH "../icon.jpg"
+
+// Icons held at once, about a screen of them while scrolling
+#define WINDOW 16
+#define WARM_UP_DECODES 64
+#define DECODES 1000
+#define TIMED_DECODES 100
+
+static settings_t g_settings = {
+    .icon_cache_kb = 16 * 1024,
+};
+
+settings_t *curr_settings() {
+    return &g_settings;
+}
+
+void logPrintf(const char *fmt, ...) {
+}
+
+static lv_img_dsc_t load_jpg(const char *path) {
+    lv_img_dsc_t dsc = {0};
+
+    FILE *fp = fopen(path, "rb");
+    BENCH_CHECK(fp != NULL, "can't open %s", path);
+
+    fseek(fp, 0, SEEK_END);
+    dsc.data_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    u8 *data = malloc(dsc.data_size);
+    BENCH_CHECK(data != NULL && fread(data, dsc.data_size, 1, fp) == 1, "can't read %s", path);
+    fclose(fp);
+
+    dsc.header.cf = LV_IMG_CF_RAW;
+    dsc.data = data;
+
+    return dsc;
+}
+
+/*
+ * icon.jpg is progressive, where scaling the DCT saves less since every
+ * scan still has to be read. Icons in NROs are mostly baseline, so the
+ * same picture is timed again encoded that way.
+ */
+static lv_img_dsc_t make_baseline(const lv_img_dsc_t *icon) {
+    lv_img_dsc_t dsc = *icon;
+
+    tjhandle decomp = tjInitDecompress();
+    tjhandle comp = tjInitCompress();
+    u8 *pixels = malloc(256 * 256 * sizeof(lv_color_t));
+
+    u8 *data = NULL;
+    unsigned long size = 0;
+
+    BENCH_CHECK(tjDecompress2(decomp, icon->data, icon->data_size, pixels, 256, 0, 256, TJPF_BGRA, 0) == 0, "%s", tjGetErrorStr());
+    BENCH_CHECK(tjCompress2(comp, pixels, 256, 0, 256, TJPF_BGRA, &data, &size, TJSAMP_420, 90, 0) == 0, "%s", tjGetErrorStr());
+
+    dsc.data = data;
+    dsc.data_size = size;
+
+    free(pixels);
+    tjDestroy(comp);
+    tjDestroy(decomp);
+
+    return dsc;
+}
+
+// What app_entry_decode_small_icon does on a miss, a fresh icon store buffer decoded into
+static u8 *decode_small_icon(const lv_img_dsc_t *icon, bool preview) {
+    u8 *data = icon_store_alloc(THUMB_SIZE);
+    BENCH_CHECK(data != NULL, "out of memory");
+
+    lv_res_t res = preview ? decoderDecodePreviewTo(icon, data, THUMB_W, THUMB_H) : decoderDecodeTo(icon, data, THUMB_W, THUMB_H);
+    BENCH_CHECK(res == LV_RES_OK, "decode failed");
+
+    return data;
+}
+
+// Scrolling through the list, every icon shown as a preview first and then decoded properly
+static void scroll(const lv_img_dsc_t *icon, u8 **window, int num_decodes) {
+    for (int i = 0; i < num_decodes; i++) {
+        u8 **slot = &window[i % WINDOW];
+
+        icon_store_release(*slot);
+        *slot = decode_small_icon(icon, (i % 2) == 0);
+    }
+}
+
+/*
+ * How icons were decoded before DCT scaling, kept as it was apart from
+ * malloc standing in for tjAlloc: a fresh decompressor, the whole image,
+ * then a bilinear downscale of that.
+ */
+static void downscale_img(u8 *src, u8 *dst, u32 src_w, u32 src_h, u32 dst_w, u32 dst_h) {
+    if (src_w == dst_w && src_h == dst_h) {
+        memcpy(dst, src, src_w * src_h * sizeof(lv_color_t));
+        return;
+    }
+
+    float x_scale = (float) src_w / (float) dst_w;
+    float y_scale = (float) src_h / (float) dst_h;
+
+    for (int x = 0; x < dst_w; x++) {
+        for (int y = 0; y < dst_h; y++) {
+            float src_x = x * x_scale;
+            float src_y = y * y_scale;
+            int pixel_x = src_x;
+            int pixel_y = src_y;
+
+            u8 *p[4] = {
+                &src[(pixel_y * src_w + pixel_x) * 4],
+                &src[(pixel_y * src_w + pixel_x + 1) * 4],
+                &src[((pixel_y + 1) * src_w + pixel_x) * 4],
+                &src[((pixel_y + 1) * src_w + pixel_x + 1) * 4],
+            };
+
+            float fx = src_x - pixel_x;
+            float fy = src_y - pixel_y;
+
+            int w[4] = {
+                (1.0f - fx) * (1.0f - fy) * 256.0,
+                fx * (1.0f - fy) * 256.0,
+                (1.0f - fx) * fy * 256.0,
+                fx * fy * 256.0,
+            };
+
+            u8 *out = &dst[(y * dst_w + x) * 4];
+            for (int c = 0; c < 4; c++)
+                out[c] = (p[0][c] * w[0] + p[1][c] * w[1] + p[2][c] * w[2] + p[3][c] * w[3]) >> 8;
+        }
+    }
+}
+
+static lv_res_t old_decode(const lv_img_dsc_t *img_dsc, u8 *dst, u16 dst_w, u16 dst_h) {
+    tjhandle decomp = tjInitDecompress();
+    if (decomp == NULL)
+        return LV_RES_INV;
+
+    int w, h, samp, color_space;
+    if (tjDecompressHeader3(decomp, img_dsc->data, img_dsc->data_size, &w, &h, &samp, &color_space)) {
+        tjDestroy(decomp);
+        return LV_RES_INV;
+    }
+
+    u8 *img_data = malloc(w * h * sizeof(lv_color_t));
+    if (img_data == NULL || tjDecompress2(decomp, img_dsc->data, img_dsc->data_size, img_data, w, 0, h, TJPF_BGRA, TJFLAG_ACCURATEDCT)) {
+        free(img_data);
+        tjDestroy(decomp);
+        return LV_RES_INV;
+    }
+
+    u8 *resized_data = malloc(dst_w * dst_h * sizeof(lv_color_t));
+    if (resized_data != NULL) {
+        downscale_img(img_data, resized_data, w, h, dst_w, dst_h);
+        memcpy(dst, resized_data, dst_w * dst_h * sizeof(lv_color_t));
+    }
+
+    free(resized_data);
+    free(img_data);
+    tjDestroy(decomp);
+
+    return (resized_data != NULL) ? LV_RES_OK : LV_RES_INV;
+}
+
+static void bench_size(const char *name, const lv_img_dsc_t *icon, u16 size) {
+    static const struct {
+        const char *name;
+        lv_res_t (*decode)(const lv_img_dsc_t *src, u8 *dst, u16 w, u16 h);
+    } cases[] = {
+        {"decode + downscale_img", old_decode},
+        {"decoderDecodeTo", decoderDecodeTo},
+    };
+
+    u8 *dst = malloc(size * size * sizeof(lv_color_t));
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        u64 ns[BENCH_RUNS];
+
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            u64 start = bench_now_ns();
+
+            for (int i = 0; i < TIMED_DECODES; i++)
+                BENCH_CHECK(cases[c].decode(icon, dst, size, size) == LV_RES_OK, "%s failed", cases[c].name);
+
+            ns[r] = (bench_now_ns() - start) / TIMED_DECODES;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s, %s 256 -> %u", cases[c].name, name, size);
+        bench_report(label, ns, BENCH_RUNS);
+    }
+
+    free(dst);
+}
+
+int main() {
+    lv_init();
+    decoderInitialize();
+    icon_store_init(THUMB_SIZE);
+
+    lv_img_dsc_t icon = load_jpg(ICON_PATH);
+    u8 *window[WINDOW] = {0};
+
+    scroll(&icon, window, WARM_UP_DECODES);
+
+    decoder_pool_stats_t pool_before;
+    icon_store_stats_t store_before;
+    decoderGetPoolStats(&pool_before);
+    icon_store_get_stats(&store_before);
+
+    u64 ns[BENCH_RUNS];
+
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        u64 start = bench_now_ns();
+        scroll(&icon, window, DECODES);
+        ns[r] = (bench_now_ns() - start) / DECODES;
+    }
+
+    decoder_pool_stats_t pool_after;
+    icon_store_stats_t store_after;
+    decoderGetPoolStats(&pool_after);
+    icon_store_get_stats(&store_after);
+
+    printf("decoder pool: %u allocs, %u reuses after warm-up\n", pool_after.allocs - pool_before.allocs, pool_after.reuses - pool_before.reuses);
+    printf("icon store: %u allocs, %u reuses after warm-up\n", store_after.allocs - store_before.allocs, store_after.reuses - store_before.reuses);
+
+    BENCH_CHECK(pool_after.allocs == pool_before.allocs, "decoder pool allocated %u buffers after warm-up", pool_after.allocs - pool_before.allocs);
+    BENCH_CHECK(store_after.allocs == store_before.allocs, "icon store allocated %u buffers after warm-up", store_after.allocs - store_before.allocs);
+
+    bench_report("small icon, preview then full", ns, BENCH_RUNS);
+
+    lv_img_dsc_t baseline = make_baseline(&icon);
+
+    bench_size("progressive", &icon, THUMB_W);
+    bench_size("progressive", &icon, 256);
+    bench_size("baseline", &baseline, THUMB_W);
+    bench_size("baseline", &baseline, 256);
+
+    tjFree((u8 *) baseline.data);
+
+    for (int i = 0; i < WINDOW; i++)
+        icon_store_release(window[i]);
+
+    free((u8 *) icon.data);
+
+    icon_store_exit();
+    decoderExit();
+
+    return 0;
+}
\ No newline at end of file
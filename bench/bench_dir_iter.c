@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "bench.h"
+#include "dir_iter.h"
+#include "tree.h"
+
+#define TREE_ROOT "build/tree_dir_iter"
+
+static bool is_nro(const char *name) {
+    const char *ext = strrchr(name, '.');
+    return ext != NULL && strcasecmp(ext, ".nro") == 0;
+}
+
+// How the scan told apps and folders apart before dir_iter, a stat per entry
+static int find_apps_stat(const char *root) {
+    DIR *dp = opendir(root);
+    if (dp == NULL)
+        return -1;
+
+    int num_apps = 0;
+
+    struct dirent *ep;
+    while ((ep = readdir(dp))) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", root, ep->d_name);
+
+        struct stat st;
+        if (stat(path, &st) != 0)
+            continue;
+
+        if (!S_ISDIR(st.st_mode)) {
+            num_apps += is_nro(ep->d_name);
+            continue;
+        }
+
+        if (strcmp(ep->d_name, ".") == 0 || strcmp(ep->d_name, "..") == 0)
+            continue;
+
+        DIR *sub_dp = opendir(path);
+        if (sub_dp == NULL)
+            continue;
+
+        struct dirent *sub_ep;
+        while ((sub_ep = readdir(sub_dp))) {
+            char sub_path[PATH_MAX];
+            snprintf(sub_path, sizeof(sub_path), "%s/%s", path, sub_ep->d_name);
+
+            if (is_nro(sub_ep->d_name) && stat(sub_path, &st) == 0 && S_ISREG(st.st_mode)) {
+                num_apps++;
+                break;
+            }
+        }
+
+        closedir(sub_dp);
+    }
+
+    closedir(dp);
+
+    return num_apps;
+}
+
+static int find_apps_dir_iter(const char *root) {
+    dir_iter_t it;
+    if (dir_iter_open(&it, root) != LV_RES_OK)
+        return -1;
+
+    int num_apps = 0;
+
+    dir_iter_entry_t *entry;
+    while ((entry = dir_iter_next(&it))) {
+        if (!entry->is_dir) {
+            num_apps += is_nro(entry->name);
+            continue;
+        }
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", root, entry->name);
+
+        dir_iter_t sub_it;
+        if (dir_iter_open(&sub_it, path) != LV_RES_OK)
+            continue;
+
+        dir_iter_entry_t *sub_entry;
+        while ((sub_entry = dir_iter_next(&sub_it))) {
+            if (!sub_entry->is_dir && is_nro(sub_entry->name)) {
+                num_apps++;
+                break;
+            }
+        }
+
+        dir_iter_close(&sub_it);
+    }
+
+    dir_iter_close(&it);
+
+    return num_apps;
+}
+
+int main() {
+    static const int sizes[] = {250, 1000};
+
+    static const struct {
+        const char *name;
+        int (*run)(const char *root);
+    } cases[] = {
+        {"readdir + stat", find_apps_stat},
+        {"dir_iter", find_apps_dir_iter},
+    };
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        tree_remove(TREE_ROOT);
+        int num_apps = tree_make(TREE_ROOT, sizes[s]);
+
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            u64 ns[BENCH_RUNS];
+
+            for (int r = 0; r < BENCH_RUNS; r++) {
+                u64 start = bench_now_ns();
+                int found = cases[c].run(TREE_ROOT);
+                ns[r] = bench_now_ns() - start;
+
+                BENCH_CHECK(found == num_apps, "%s found %d apps, expected %d", cases[c].name, found, num_apps);
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "%s, %d entries", cases[c].name, sizes[s]);
+            bench_report(label, ns, BENCH_RUNS);
+        }
+    }
+
+    tree_remove(TREE_ROOT);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bench.h"
+#include "resample.h"
+
+#define BENCH_ITERS 200
+
+typedef struct {
+    u32 src_w;
+    u32 src_h;
+    u32 dst_w;
+    u32 dst_h;
+} size_case_t;
+
+static const size_case_t g_golden_cases[] = {
+    {256, 256, 72, 72}, // Small icons
+    {300, 200, 72, 72}, // Not square, and a different factor per axis
+    {257, 131, 72, 50}, // Odd sizes that don't divide evenly
+    {96, 96, 72, 72}, // Just under 2x, two or three taps
+    {32, 32, 72, 72}, // Enlarged, like a preview
+    {72, 72, 72, 72},
+};
+
+// Noise on top of gradients, with alpha all over the place
+static u8 *make_image(u32 w, u32 h, u32 seed) {
+    u8 *img = malloc(w * h * 4);
+
+    for (u32 y = 0; y < h; y++) {
+        for (u32 x = 0; x < w; x++) {
+            u8 *px = &img[(y * w + x) * 4];
+
+            px[0] = (x * 255 / w + bench_rand(&seed) % 32) & 0xff;
+            px[1] = (y * 255 / h) & 0xff;
+            px[2] = bench_rand(&seed) & 0xff;
+            px[3] = ((x ^ y) & 8) ? 0xff : bench_rand(&seed) & 0xff;
+        }
+    }
+
+    return img;
+}
+
+/*
+ * The filter resample_bgra is meant to be, in doubles: an area average
+ * when reducing, bilinear with the center clamped to the image otherwise.
+ */
+static void ref_weights(u32 src_len, u32 dst_len, u32 i, double *weights) {
+    double scale = (double) src_len / dst_len;
+
+    memset(weights, 0, src_len * sizeof(double));
+
+    if (scale > 1.0) {
+        double lo = i * scale;
+        double hi = lo + scale;
+
+        for (u32 j = floor(lo); j < src_len && j < hi; j++) {
+            double from = fmax(j, lo);
+            double to = fmin(j + 1, hi);
+
+            weights[j] = (to - from) / scale;
+        }
+    } else {
+        double center = fmin(fmax((i + 0.5) * scale - 0.5, 0.0), src_len - 1);
+        u32 first = center;
+        double frac = center - first;
+
+        weights[first] = 1.0 - frac;
+        if (first + 1 < src_len)
+            weights[first + 1] = frac;
+    }
+}
+
+static double *reference(const u8 *src, const size_case_t *c) {
+    double *inter = calloc(c->src_h * c->dst_w * 4, sizeof(double));
+    double *out = calloc(c->dst_h * c->dst_w * 4, sizeof(double));
+    double weights[c->src_w > c->src_h ? c->src_w : c->src_h];
+
+    for (u32 x = 0; x < c->dst_w; x++) {
+        ref_weights(c->src_w, c->dst_w, x, weights);
+
+        for (u32 y = 0; y < c->src_h; y++) {
+            for (u32 j = 0; j < c->src_w; j++) {
+                for (int ch = 0; ch < 4; ch++)
+                    inter[(y * c->dst_w + x) * 4 + ch] += src[(y * c->src_w + j) * 4 + ch] * weights[j];
+            }
+        }
+    }
+
+    for (u32 y = 0; y < c->dst_h; y++) {
+        ref_weights(c->src_h, c->dst_h, y, weights);
+
+        for (u32 j = 0; j < c->src_h; j++) {
+            for (u32 x = 0; x < c->dst_w * 4; x++)
+                out[y * c->dst_w * 4 + x] += inter[j * c->dst_w * 4 + x] * weights[j];
+        }
+    }
+
+    free(inter);
+
+    return out;
+}
+
+static u8 *run_resample(const u8 *src, const size_case_t *c) {
+    u8 *dst = malloc(c->dst_w * c->dst_h * 4);
+    void *scratch = malloc(resample_scratch_size(c->src_w, c->src_h, c->dst_w, c->dst_h));
+
+    resample_bgra(src, c->src_w, c->src_h, dst, c->dst_w, c->dst_h, scratch);
+
+    free(scratch);
+
+    return dst;
+}
+
+static void check_golden(const size_case_t *c) {
+    u8 *src = make_image(c->src_w, c->src_h, c->src_w * 31 + c->src_h);
+    u8 *dst = run_resample(src, c);
+    double *ref = reference(src, c);
+
+    double max_err = 0.0;
+    u32 hash = 2166136261u;
+
+    // The hash is there so the scalar and NEON builds can be compared byte for byte
+    for (u32 i = 0; i < c->dst_w * c->dst_h * 4; i++) {
+        max_err = fmax(max_err, fabs(dst[i] - ref[i]));
+        hash = (hash ^ dst[i]) * 16777619u;
+    }
+
+    printf("golden %ux%u -> %ux%u: max error %.3f, hash %08x\n", c->src_w, c->src_h, c->dst_w, c->dst_h, max_err, hash);
+
+    // Half a level for rounding, and a little for the Q14 weights
+    BENCH_CHECK(max_err <= 0.6, "%ux%u -> %ux%u is off by %.3f", c->src_w, c->src_h, c->dst_w, c->dst_h, max_err);
+
+    // A flat image has to stay exactly flat
+    memset(src, 0x7b, c->src_w * c->src_h * 4);
+    free(dst);
+    dst = run_resample(src, c);
+
+    for (u32 i = 0; i < c->dst_w * c->dst_h * 4; i++)
+        BENCH_CHECK(dst[i] == 0x7b, "%ux%u -> %ux%u isn't flat at %u", c->src_w, c->src_h, c->dst_w, c->dst_h, i);
+
+    free(ref);
+    free(dst);
+    free(src);
+}
+
+/*
+ * What resample_bgra replaced, kept as it was. It reads a pixel past the
+ * right edge and a row past the bottom, the source gets padding for that.
+ */
+static void downscale_img(u8 *src, u8 *dst, u32 src_w, u32 src_h, u32 dst_w, u32 dst_h) {
+    float x_scale = (float) src_w / (float) dst_w;
+    float y_scale = (float) src_h / (float) dst_h;
+
+    for (int x = 0; x < dst_w; x++) {
+        for (int y = 0; y < dst_h; y++) {
+            float src_x = x * x_scale;
+            float src_y = y * y_scale;
+            int pixel_x = src_x;
+            int pixel_y = src_y;
+
+            u8 *p[4] = {
+                &src[(pixel_y * src_w + pixel_x) * 4],
+                &src[(pixel_y * src_w + pixel_x + 1) * 4],
+                &src[((pixel_y + 1) * src_w + pixel_x) * 4],
+                &src[((pixel_y + 1) * src_w + pixel_x + 1) * 4],
+            };
+
+            float fx = src_x - pixel_x;
+            float fy = src_y - pixel_y;
+
+            int w[4] = {
+                (1.0f - fx) * (1.0f - fy) * 256.0,
+                fx * (1.0f - fy) * 256.0,
+                (1.0f - fx) * fy * 256.0,
+                fx * fy * 256.0,
+            };
+
+            u8 *out = &dst[(y * dst_w + x) * 4];
+            for (int c = 0; c < 4; c++)
+                out[c] = (p[0][c] * w[0] + p[1][c] * w[1] + p[2][c] * w[2] + p[3][c] * w[3]) >> 8;
+        }
+    }
+}
+
+static void bench_case(const size_case_t *c) {
+    u8 *src = make_image(c->src_w, c->src_h + 2, 7);
+    u8 *dst = malloc(c->dst_w * c->dst_h * 4);
+    void *scratch = malloc(resample_scratch_size(c->src_w, c->src_h, c->dst_w, c->dst_h));
+
+    u64 old_ns[BENCH_RUNS];
+    u64 new_ns[BENCH_RUNS];
+
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        u64 start = bench_now_ns();
+        for (int i = 0; i < BENCH_ITERS; i++)
+            downscale_img(src, dst, c->src_w, c->src_h, c->dst_w, c->dst_h);
+        old_ns[r] = (bench_now_ns() - start) / BENCH_ITERS;
+
+        start = bench_now_ns();
+        for (int i = 0; i < BENCH_ITERS; i++)
+            resample_bgra(src, c->src_w, c->src_h, dst, c->dst_w, c->dst_h, scratch);
+        new_ns[r] = (bench_now_ns() - start) / BENCH_ITERS;
+    }
+
+    char label[64];
+
+    snprintf(label, sizeof(label), "downscale_img %ux%u -> %ux%u", c->src_w, c->src_h, c->dst_w, c->dst_h);
+    bench_report(label, old_ns, BENCH_RUNS);
+
+    snprintf(label, sizeof(label), "resample_bgra %ux%u -> %ux%u", c->src_w, c->src_h, c->dst_w, c->dst_h);
+    bench_report(label, new_ns, BENCH_RUNS);
+
+    free(scratch);
+    free(dst);
+    free(src);
+}
+
+int main(int argc, char **argv) {
+    for (size_t i = 0; i < sizeof(g_golden_cases) / sizeof(g_golden_cases[0]); i++)
+        check_golden(&g_golden_cases[i]);
+
+    // --check leaves the timing out, for builds that are only there to be compared
+    if (argc > 1 && strcmp(argv[1], "--check") == 0)
+        return 0;
+
+    bench_case(&g_golden_cases[0]);
+    bench_case(&g_golden_cases[4]);
+
+    return 0;
+}
\ No newline at end of file
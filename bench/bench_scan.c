@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "bench.h"
+#include "dir_iter.h"
+#include "scan_pool.h"
+#include "tree.h"
+
+#define TREE_ROOT "build/tree_scan"
+#define TREE_ENTRIES 500
+
+static bool is_nro(const char *name) {
+    const char *ext = strrchr(name, '.');
+    return ext != NULL && strcasecmp(ext, ".nro") == 0;
+}
+
+// The same reads nro_read_assets does: the header, then the asset header and NACP in one go
+static char *read_app(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    tree_nro_head_t head;
+    tree_asset_header_t asset_header;
+    char *nacp = malloc(TREE_NACP_SIZE);
+
+    bool ok = nacp != NULL
+        && fread(&head, sizeof(head), 1, fp) == 1 && head.magic == TREE_NRO_MAGIC
+        && fseek(fp, head.asset_offset, SEEK_SET) == 0
+        && fread(&asset_header, sizeof(asset_header), 1, fp) == 1 && asset_header.magic == TREE_ASSET_MAGIC
+        && fread(nacp, TREE_NACP_SIZE, 1, fp) == 1;
+
+    fclose(fp);
+
+    if (!ok) {
+        free(nacp);
+        return NULL;
+    }
+
+    nacp[TREE_NACP_SIZE - 1] = '\0';
+
+    return nacp;
+}
+
+// Stands in for scan_dir_entry, minus the app index
+static void *scan_job(const scan_job_t *job) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", TREE_ROOT, job->name);
+
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return NULL;
+
+    if (!job->is_dir)
+        return read_app(path);
+
+    dir_iter_t it;
+    if (dir_iter_open(&it, path) != LV_RES_OK)
+        return NULL;
+
+    char *result = NULL;
+
+    dir_iter_entry_t *entry;
+    while (result == NULL && (entry = dir_iter_next(&it))) {
+        if (entry->is_dir || !is_nro(entry->name))
+            continue;
+
+        char app_path[PATH_MAX];
+        snprintf(app_path, sizeof(app_path), "%s/%s", path, entry->name);
+
+        result = read_app(app_path);
+    }
+
+    dir_iter_close(&it);
+
+    return result;
+}
+
+static bool scan_done(void *result, void *arg) {
+    (*(int *) arg)++;
+    free(result);
+
+    return true;
+}
+
+static int run_scan(int num_workers) {
+    dir_iter_t it;
+    if (dir_iter_open(&it, TREE_ROOT) != LV_RES_OK)
+        return -1;
+
+    scan_queue_t queue;
+    scan_queue_init(&queue);
+
+    dir_iter_entry_t *entry;
+    while ((entry = dir_iter_next(&it))) {
+        if (entry->is_dir || is_nro(entry->name))
+            scan_queue_add(&queue, entry->name, entry->is_dir);
+    }
+
+    dir_iter_close(&it);
+
+    int num_found = 0;
+    scan_pool_run(&queue, num_workers, scan_job, scan_done, &num_found);
+
+    scan_queue_clear(&queue);
+
+    return num_found;
+}
+
+int main() {
+    tree_remove(TREE_ROOT);
+    int num_apps = tree_make(TREE_ROOT, TREE_ENTRIES);
+
+    // Cold runs read from the disk, warm ones from the page cache, which is closer to how fast parsing alone is
+    for (int cold = 1; cold >= 0; cold--) {
+        for (int num_workers = 1; num_workers <= SCAN_POOL_MAX_WORKERS; num_workers++) {
+            u64 ns[BENCH_RUNS];
+
+            for (int r = 0; r < BENCH_RUNS; r++) {
+                if (cold)
+                    tree_drop_cache(TREE_ROOT);
+
+                u64 start = bench_now_ns();
+                int found = run_scan(num_workers);
+                ns[r] = bench_now_ns() - start;
+
+                BENCH_CHECK(found == num_apps, "found %d apps, expected %d", found, num_apps);
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "%s scan, %d apps, %d workers", cold ? "cold" : "warm", num_apps, num_workers);
+            bench_report(label, ns, BENCH_RUNS);
+        }
+    }
+
+    tree_remove(TREE_ROOT);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "bench.h"
+#include "catalog.h"
+#include "search.h"
+
+#define QUERY_ITERS 100
+
+static const char *g_words[] = {
+    "homebrew", "retro", "arch", "Checkpoint", "edizon", "goldleaf", "hb", "Tinfoil",
+    "nx", "shop", "menu", "loader", "emu", "Player", "save", "manager",
+};
+
+#define NUM_WORDS (sizeof(g_words) / sizeof(g_words[0]))
+
+static const char *g_authors[] = {"", "J-D-K", "XorTroll", "Adubbz", "FlagBrew", "WerWolv"};
+
+#define NUM_AUTHORS (sizeof(g_authors) / sizeof(g_authors[0]))
+
+// What gets typed, one key at a time like on the search keyboard
+static const char *g_queries[] = {"retro", "save man", "xortroll", "tin", "player 12", "q"};
+
+#define NUM_QUERIES (sizeof(g_queries) / sizeof(g_queries[0]))
+
+// The catalog's entries would normally come from app_entry_scan
+void app_entry_free(app_entry_t *entry) {
+    free(entry);
+}
+
+lv_res_t app_entry_scan(app_entry_scan_cb_t cb, void *arg) {
+    return LV_RES_INV;
+}
+
+static char *make_names(int num) {
+    char *names = malloc(num * 32);
+    u32 seed = 1;
+
+    for (int i = 0; i < num; i++) {
+        snprintf(&names[i * 32], 32, "%s%s %s %u", g_words[bench_rand(&seed) % NUM_WORDS], g_words[bench_rand(&seed) % NUM_WORDS], g_words[bench_rand(&seed) % NUM_WORDS], bench_rand(&seed) % 1000);
+    }
+
+    return names;
+}
+
+static void make_catalog(catalog_t *catalog, const char *names, int num) {
+    catalog_init(catalog);
+
+    for (int i = 0; i < num; i++) {
+        app_entry_t *entry = calloc(1, sizeof(app_entry_t));
+
+        entry->path = entry->name = &names[i * 32];
+        entry->author = g_authors[i % NUM_AUTHORS];
+        entry->starred = (i % 10) == 0;
+
+        app_entry_update_sort_key(entry);
+        catalog_append(catalog, entry);
+    }
+
+    catalog_sort(catalog);
+}
+
+static bool has_word_prefix(const char *str, const char *term, size_t len) {
+    for (size_t i = 0; str[i] != '\0'; i++) {
+        bool word_start = isalnum((unsigned char) str[i]) && (i == 0 || !isalnum((unsigned char) str[i - 1]) || (isupper((unsigned char) str[i]) && islower((unsigned char) str[i - 1])));
+
+        if (word_start && strncasecmp(str + i, term, len) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// Every entry against every term, the slow way, for what search_query has to come up with
+static int count_matches(catalog_t *catalog, const char *query) {
+    int num = 0;
+
+    for (int i = 0; i < catalog->len; i++) {
+        app_entry_t *entry = catalog->entries[i];
+        bool match = true;
+
+        for (const char *p = query; *p != '\0' && match;) {
+            while (*p == ' ')
+                p++;
+
+            size_t len = strcspn(p, " ");
+            if (len == 0)
+                break;
+
+            match = has_word_prefix(entry->name, p, len) || has_word_prefix(entry->author, p, len);
+            p += len;
+        }
+
+        if (match)
+            num++;
+    }
+
+    return num;
+}
+
+static void check_results(search_t *search, catalog_t *catalog, const char *query) {
+    int expected = count_matches(catalog, query);
+    BENCH_CHECK(search->num_results == expected, "\"%s\" found %d, expected %d", query, search->num_results, expected);
+
+    for (int i = 1; i < search->num_results; i++)
+        BENCH_CHECK(app_entry_cmp(search->results[i - 1], search->results[i]) <= 0 && search->results[i - 1] != search->results[i], "\"%s\" out of order at %d", query, i);
+}
+
+// Types the query out, running it after every key like apply_search does, then clears it
+static void type_query(search_t *search, catalog_t *catalog, const char *query, bool check) {
+    char typed[SEARCH_QUERY_LEN] = {0};
+
+    for (size_t i = 0; query[i] != '\0'; i++) {
+        typed[i] = query[i];
+        BENCH_CHECK(search_query(search, typed) == LV_RES_OK, "\"%s\" failed", typed);
+
+        if (check)
+            check_results(search, catalog, typed);
+    }
+
+    search_query(search, "");
+}
+
+int main() {
+    static const int sizes[] = {1000, 10000};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int num = sizes[s];
+        char *names = make_names(num);
+
+        catalog_t catalog;
+        make_catalog(&catalog, names, num);
+
+        search_t search;
+        search_init(&search);
+
+        u64 build_ns[BENCH_RUNS];
+
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            u64 start = bench_now_ns();
+            BENCH_CHECK(search_build(&search, &catalog) == LV_RES_OK, "search_build failed");
+            build_ns[r] = bench_now_ns() - start;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "search_build, %d", num);
+        bench_report(label, build_ns, BENCH_RUNS);
+
+        for (size_t q = 0; q < NUM_QUERIES; q++) {
+            type_query(&search, &catalog, g_queries[q], true);
+
+            u64 ns[BENCH_RUNS];
+            size_t keys = strlen(g_queries[q]);
+
+            for (int r = 0; r < BENCH_RUNS; r++) {
+                u64 start = bench_now_ns();
+
+                for (int i = 0; i < QUERY_ITERS; i++)
+                    type_query(&search, &catalog, g_queries[q], false);
+
+                ns[r] = (bench_now_ns() - start) / (QUERY_ITERS * keys);
+            }
+
+            snprintf(label, sizeof(label), "search_query per key, \"%s\", %d", g_queries[q], num);
+            bench_report(label, ns, BENCH_RUNS);
+        }
+
+        search_clear(&search);
+        catalog_clear(&catalog);
+        free(names);
+    }
+
+    return 0;
+}
\ No newline at end of file
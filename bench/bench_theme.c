@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "theme_pack.h"
+#include "zip_reader.h"
+
+// Both made by tools/gen_theme.py from the same theme folder, see the Makefile
+#define PACK_PATH "build/theme.hbctheme"
+#define ZIP_PATH "build/theme.zip"
+
+#define LOADS 20
+
+void logPrintf(const char *fmt, ...) {
+}
+
+// Both loaders read into buffers like asset_load's, one per asset
+typedef struct {
+    const char *name;
+    u32 size;
+    u8 *buf;
+} asset_t;
+
+// Every file in the pack, which gen_theme.py puts in the zip as well
+static asset_t *list_assets(u32 *num) {
+    theme_pack_t pack;
+    BENCH_CHECK(theme_pack_open(&pack, PACK_PATH) == LV_RES_OK, "can't open %s", PACK_PATH);
+
+    asset_t *assets = calloc(pack.count, sizeof(asset_t));
+
+    for (u32 i = 0; i < pack.count; i++) {
+        assets[i].name = strdup(pack.recs[i].name);
+        assets[i].size = pack.recs[i].size;
+        assets[i].buf = malloc(pack.recs[i].size);
+    }
+
+    *num = pack.count;
+    theme_pack_close(&pack);
+
+    return assets;
+}
+
+// What theme_init does with a pack, from opening it to having every asset in memory
+static void load_pack(asset_t *assets, u32 num) {
+    theme_pack_t pack;
+    BENCH_CHECK(theme_pack_open(&pack, PACK_PATH) == LV_RES_OK, "can't open %s", PACK_PATH);
+
+    for (u32 i = 0; i < num; i++) {
+        const theme_pack_rec_t *rec = theme_pack_find(&pack, assets[i].name);
+
+        BENCH_CHECK(rec != NULL && rec->size == assets[i].size, "%s isn't in the pack", assets[i].name);
+        BENCH_CHECK(theme_pack_read(&pack, rec, assets[i].buf) == LV_RES_OK, "can't read %s from the pack", assets[i].name);
+    }
+
+    theme_pack_close(&pack);
+}
+
+// The same from an installed theme's zip. Its images aren't encoded, so they're bigger once read
+static void load_zip(asset_t *assets, u32 num, u64 *bytes) {
+    zip_reader_t zip;
+    BENCH_CHECK(zip_reader_open(&zip, ZIP_PATH, true) == LV_RES_OK, "can't open %s", ZIP_PATH);
+
+    *bytes = 0;
+
+    for (u32 i = 0; i < num; i++) {
+        const zip_member_t *member = zip_reader_find(&zip, assets[i].name);
+        BENCH_CHECK(member != NULL, "%s isn't in the zip", assets[i].name);
+
+        u8 *buf = malloc(member->size);
+        BENCH_CHECK(zip_reader_read(&zip, member, buf) == LV_RES_OK, "can't read %s from the zip", assets[i].name);
+
+        // Files the pack stores as they are have to come out of the zip the same
+        if (member->size == assets[i].size)
+            BENCH_CHECK(memcmp(buf, assets[i].buf, member->size) == 0, "%s differs between the pack and the zip", assets[i].name);
+
+        *bytes += member->size;
+        free(buf);
+    }
+
+    zip_reader_close(&zip);
+}
+
+int main() {
+    u32 num;
+    asset_t *assets = list_assets(&num);
+
+    u64 pack_bytes = 0;
+    for (u32 i = 0; i < num; i++)
+        pack_bytes += assets[i].size;
+
+    // Warm the page cache for both, so neither is timed against the disk
+    u64 zip_bytes;
+    load_pack(assets, num);
+    load_zip(assets, num, &zip_bytes);
+
+    printf("%u assets, %llu bytes from the pack, %llu from the zip\n", num, (unsigned long long) pack_bytes, (unsigned long long) zip_bytes);
+
+    u64 pack_ns[BENCH_RUNS];
+    u64 zip_ns[BENCH_RUNS];
+
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        u64 start = bench_now_ns();
+        for (int i = 0; i < LOADS; i++)
+            load_pack(assets, num);
+        pack_ns[r] = (bench_now_ns() - start) / LOADS;
+
+        start = bench_now_ns();
+        for (int i = 0; i < LOADS; i++)
+            load_zip(assets, num, &zip_bytes);
+        zip_ns[r] = (bench_now_ns() - start) / LOADS;
+    }
+
+    bench_report("theme_pack_read, every asset", pack_ns, BENCH_RUNS);
+    bench_report("zip_reader_read, every asset", zip_ns, BENCH_RUNS);
+
+    for (u32 i = 0; i < num; i++) {
+        free((char *) assets[i].name);
+        free(assets[i].buf);
+    }
+
+    free(assets);
+
+    return 0;
+}
\ No newline at end of file
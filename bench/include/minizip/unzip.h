@@ -0,0 +1,58 @@
+#pragma once
+
+// The part of minizip's unzip API zip_reader.c uses, over the host's zlib. See unzip.c
+
+typedef void *unzFile;
+typedef unsigned long uLong;
+
+#define UNZ_OK 0
+#define UNZ_END_OF_LIST_OF_FILE (-100)
+#define UNZ_ERRNO (-1)
+#define UNZ_EOF 0
+#define UNZ_PARAMERROR (-102)
+#define UNZ_BADZIPFILE (-103)
+#define UNZ_INTERNALERROR (-104)
+#define UNZ_CRCERROR (-105)
+
+typedef struct {
+    uLong number_entry;
+    uLong size_comment;
+} unz_global_info;
+
+typedef struct {
+    uLong pos_in_zip_directory;
+    uLong num_of_file;
+} unz_file_pos;
+
+typedef struct {
+    uLong version;
+    uLong version_needed;
+    uLong flag;
+    uLong compression_method;
+    uLong dosDate;
+    uLong crc;
+    uLong compressed_size;
+    uLong uncompressed_size;
+    uLong size_filename;
+    uLong size_file_extra;
+    uLong size_file_comment;
+    uLong disk_num_start;
+    uLong internal_fa;
+    uLong external_fa;
+} unz_file_info;
+
+unzFile unzOpen(const char *path);
+int unzClose(unzFile file);
+
+int unzGetGlobalInfo(unzFile file, unz_global_info *pglobal_info);
+
+int unzGoToFirstFile(unzFile file);
+int unzGoToNextFile(unzFile file);
+int unzGetFilePos(unzFile file, unz_file_pos *file_pos);
+int unzGoToFilePos(unzFile file, unz_file_pos *file_pos);
+
+int unzGetCurrentFileInfo(unzFile file, unz_file_info *pfile_info, char *szFileName, uLong fileNameBufferSize, void *extraField, uLong extraFieldBufferSize, char *szComment, uLong commentBufferSize);
+
+int unzOpenCurrentFile(unzFile file);
+int unzReadCurrentFile(unzFile file, void *buf, unsigned len);
+int unzCloseCurrentFile(unzFile file);
\ No newline at end of file
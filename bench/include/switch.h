@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * Host stand-in for the little of libnx that the benchmarked sources and
+ * LVGL's tick use. Ticks are nanoseconds here.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+typedef u32 Result;
+
+#define BIT(n) (1U << (n))
+
+static inline u64 armGetSystemTick() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline u64 armGetSystemTickFreq() {
+    return 1000000000ull;
+}
+
+static inline u64 armTicksToNs(u64 tick) {
+    return tick;
+}
\ No newline at end of file
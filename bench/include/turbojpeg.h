@@ -0,0 +1,39 @@
+#pragma once
+
+// The part of the TurboJPEG API decoder.c and the benches use, over the host's libjpeg-turbo. See turbojpeg.c
+
+typedef void *tjhandle;
+
+typedef struct {
+    int num;
+    int denom;
+} tjscalingfactor;
+
+#define TJSCALED(dimension, scalingFactor) (((dimension) * (scalingFactor).num + (scalingFactor).denom - 1) / (scalingFactor).denom)
+
+enum TJPF {
+    TJPF_BGRA = 8,
+};
+
+enum TJSAMP {
+    TJSAMP_420 = 2,
+};
+
+#define TJFLAG_FASTUPSAMPLE 256
+#define TJFLAG_FASTDCT 2048
+#define TJFLAG_ACCURATEDCT 4096
+
+tjhandle tjInitDecompress(void);
+int tjDestroy(tjhandle handle);
+
+int tjDecompressHeader3(tjhandle handle, const unsigned char *jpegBuf, unsigned long jpegSize, int *width, int *height, int *jpegSubsamp, int *jpegColorspace);
+tjscalingfactor *tjGetScalingFactors(int *numScalingFactors);
+int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf, unsigned long jpegSize, unsigned char *dstBuf, int width, int pitch, int height, int pixelFormat, int flags);
+
+tjhandle tjInitCompress(void);
+
+// Only 4:2:0, *jpegBuf is allocated and goes to tjFree
+int tjCompress2(tjhandle handle, const unsigned char *srcBuf, int width, int pitch, int height, int pixelFormat, unsigned char **jpegBuf, unsigned long *jpegSize, int jpegSubsamp, int jpegQual, int flags);
+void tjFree(unsigned char *buffer);
+
+char *tjGetErrorStr(void);
\ No newline at end of file
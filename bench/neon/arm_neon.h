@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+ * Plain C versions of the NEON intrinsics resample.c uses, so its NEON
+ * path can run and be compared on a host without one. Only the results
+ * are emulated, `make neon-check` is what proves it builds for aarch64.
+ */
+
+#include <stdint.h>
+
+typedef struct { uint8_t v[8]; } uint8x8_t;
+typedef struct { uint16_t v[4]; } uint16x4_t;
+typedef struct { uint16_t v[8]; } uint16x8_t;
+typedef struct { uint32_t v[2]; } uint32x2_t;
+typedef struct { uint32_t v[4]; } uint32x4_t;
+
+static inline uint32x4_t vdupq_n_u32(uint32_t x) {
+    return (uint32x4_t) {{x, x, x, x}};
+}
+
+static inline uint32x2_t vld1_dup_u32(const uint32_t *p) {
+    uint32_t x;
+    __builtin_memcpy(&x, p, sizeof(x));
+
+    return (uint32x2_t) {{x, x}};
+}
+
+static inline uint8x8_t vreinterpret_u8_u32(uint32x2_t a) {
+    uint8x8_t r;
+    __builtin_memcpy(r.v, a.v, sizeof(r.v));
+
+    return r;
+}
+
+static inline uint16x8_t vmovl_u8(uint8x8_t a) {
+    uint16x8_t r;
+    for (int i = 0; i < 8; i++)
+        r.v[i] = a.v[i];
+
+    return r;
+}
+
+static inline uint16x4_t vget_low_u16(uint16x8_t a) {
+    return (uint16x4_t) {{a.v[0], a.v[1], a.v[2], a.v[3]}};
+}
+
+static inline uint16x4_t vget_high_u16(uint16x8_t a) {
+    return (uint16x4_t) {{a.v[4], a.v[5], a.v[6], a.v[7]}};
+}
+
+static inline uint16x8_t vcombine_u16(uint16x4_t lo, uint16x4_t hi) {
+    return (uint16x8_t) {{lo.v[0], lo.v[1], lo.v[2], lo.v[3], hi.v[0], hi.v[1], hi.v[2], hi.v[3]}};
+}
+
+static inline uint32x4_t vmlal_n_u16(uint32x4_t acc, uint16x4_t a, uint16_t b) {
+    for (int i = 0; i < 4; i++)
+        acc.v[i] += (uint32_t) a.v[i] * b;
+
+    return acc;
+}
+
+// Rounding shifts work on the widened value, so adding the rounding bit can't overflow
+static inline uint16x4_t vrshrn_n_u32(uint32x4_t a, int n) {
+    uint16x4_t r;
+    for (int i = 0; i < 4; i++)
+        r.v[i] = (uint16_t) (((uint64_t) a.v[i] + (1ull << (n - 1))) >> n);
+
+    return r;
+}
+
+static inline uint32x4_t vrshrq_n_u32(uint32x4_t a, int n) {
+    uint32x4_t r;
+    for (int i = 0; i < 4; i++)
+        r.v[i] = (uint32_t) (((uint64_t) a.v[i] + (1ull << (n - 1))) >> n);
+
+    return r;
+}
+
+static inline uint16x4_t vmovn_u32(uint32x4_t a) {
+    uint16x4_t r;
+    for (int i = 0; i < 4; i++)
+        r.v[i] = (uint16_t) a.v[i];
+
+    return r;
+}
+
+static inline uint8x8_t vqmovn_u16(uint16x8_t a) {
+    uint8x8_t r;
+    for (int i = 0; i < 8; i++)
+        r.v[i] = (a.v[i] > 0xff) ? 0xff : a.v[i];
+
+    return r;
+}
+
+static inline uint16x8_t vld1q_u16(const uint16_t *p) {
+    uint16x8_t r;
+    __builtin_memcpy(r.v, p, sizeof(r.v));
+
+    return r;
+}
+
+static inline void vst1_u16(uint16_t *p, uint16x4_t a) {
+    __builtin_memcpy(p, a.v, sizeof(a.v));
+}
+
+static inline void vst1_u8(uint8_t *p, uint8x8_t a) {
+    __builtin_memcpy(p, a.v, sizeof(a.v));
+}
\ No newline at end of file
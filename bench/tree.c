@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "tree.h"
+
+// Most of an NRO is code a scan never reads, it's left as a hole
+#define TREE_CODE_SIZE (512 * 1024)
+
+static void write_nro(const char *path, int idx) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+        return;
+
+    tree_nro_head_t head = {.magic = TREE_NRO_MAGIC, .asset_offset = TREE_CODE_SIZE};
+    fwrite(&head, sizeof(head), 1, fp);
+
+    fseek(fp, TREE_CODE_SIZE, SEEK_SET);
+
+    tree_asset_header_t asset_header = {.magic = TREE_ASSET_MAGIC, .nacp_offset = sizeof(asset_header), .nacp_size = TREE_NACP_SIZE};
+    fwrite(&asset_header, sizeof(asset_header), 1, fp);
+
+    char nacp[TREE_NACP_SIZE] = {0};
+    snprintf(nacp, sizeof(nacp), "App %d", idx);
+    fwrite(nacp, sizeof(nacp), 1, fp);
+
+    fclose(fp);
+}
+
+static void write_file(const char *path, size_t size) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+        return;
+
+    char buf[256] = {0};
+    while (size > 0) {
+        size_t len = (size < sizeof(buf)) ? size : sizeof(buf);
+        fwrite(buf, len, 1, fp);
+        size -= len;
+    }
+
+    fclose(fp);
+}
+
+int tree_make(const char *root, int num_entries) {
+    mkdir(root, 0755);
+
+    int num_apps = 0;
+
+    for (int i = 0; i < num_entries; i++) {
+        char path[PATH_MAX];
+
+        switch (i % 10) {
+            // Loose apps
+            case 0 ... 2: {
+                snprintf(path, sizeof(path), "%s/app%04d.nro", root, i);
+                write_nro(path, i);
+                num_apps++;
+            } break;
+
+            // Something that isn't an app
+            case 3: {
+                snprintf(path, sizeof(path), "%s/notes%04d.txt", root, i);
+                write_file(path, 1024);
+            } break;
+
+            // Apps in their own folder, with their config and data next to them
+            default: {
+                snprintf(path, sizeof(path), "%s/app%04d", root, i);
+                mkdir(path, 0755);
+
+                for (int j = 0; j < 3; j++) {
+                    snprintf(path, sizeof(path), "%s/app%04d/data%d.bin", root, i, j);
+                    write_file(path, 4096);
+                }
+
+                snprintf(path, sizeof(path), "%s/app%04d/app%04d.nro", root, i, i);
+                write_nro(path, i);
+                num_apps++;
+            } break;
+        }
+    }
+
+    return num_apps;
+}
+
+// Calls fn on every file under path, depth first
+static void walk(const char *path, void (*fn)(const char *path, bool is_dir)) {
+    DIR *dp = opendir(path);
+    if (dp == NULL)
+        return;
+
+    struct dirent *ep;
+    while ((ep = readdir(dp))) {
+        if (strcmp(ep->d_name, ".") == 0 || strcmp(ep->d_name, "..") == 0)
+            continue;
+
+        char sub_path[PATH_MAX];
+        snprintf(sub_path, sizeof(sub_path), "%s/%s", path, ep->d_name);
+
+        if (ep->d_type == DT_DIR)
+            walk(sub_path, fn);
+
+        fn(sub_path, ep->d_type == DT_DIR);
+    }
+
+    closedir(dp);
+}
+
+static void remove_cb(const char *path, bool is_dir) {
+    if (is_dir)
+        rmdir(path);
+    else
+        unlink(path);
+}
+
+static void drop_cb(const char *path, bool is_dir) {
+    if (is_dir)
+        return;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return;
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+void tree_remove(const char *root) {
+    walk(root, remove_cb);
+    rmdir(root);
+}
+
+void tree_drop_cache(const char *root) {
+    walk(root, drop_cb);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <switch.h>
+
+#define TREE_NRO_MAGIC 0x304f524e // "NRO0"
+#define TREE_ASSET_MAGIC 0x54455341 // "ASET"
+#define TREE_NACP_SIZE 0x4000
+
+// Laid out like an NRO as far as a scan reads it: the header, then the asset header and NACP after the code
+typedef struct {
+    u32 magic;
+    u32 asset_offset;
+    u8 padding[0x78];
+} tree_nro_head_t;
+
+typedef struct {
+    u32 magic;
+    u32 nacp_offset; // From the asset header
+    u32 nacp_size;
+    u32 reserved;
+} tree_asset_header_t;
+
+/*
+ * Builds a stand-in for sdmc:/switch under root with num_entries entries:
+ * apps in folders of their own next to a few other files, loose apps and
+ * files that aren't apps. Returns how many apps it holds.
+ */
+int tree_make(const char *root, int num_entries);
+void tree_remove(const char *root);
+
+// Asks the kernel to forget the cached file contents, so reads go to the disk again
+void tree_drop_cache(const char *root);
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+
+#include "turbojpeg.h"
+
+// A handle is a decompressor or compressor that longjmps back out on errors instead of exiting
+typedef struct {
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    jmp_buf jmp;
+} decomp_t;
+
+typedef struct {
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    jmp_buf jmp;
+} comp_t;
+
+// Largest first, like libturbojpeg's
+static tjscalingfactor g_factors[] = {
+    {2, 1}, {15, 8}, {7, 4}, {13, 8}, {3, 2}, {11, 8}, {5, 4}, {9, 8},
+    {1, 1}, {7, 8}, {3, 4}, {5, 8}, {1, 2}, {3, 8}, {1, 4}, {1, 8},
+};
+
+static char g_err_str[JMSG_LENGTH_MAX] = "No error";
+
+static void error_exit(j_common_ptr cinfo) {
+    (*cinfo->err->format_message)(cinfo, g_err_str);
+
+    if (cinfo->is_decompressor)
+        longjmp(((decomp_t *) cinfo)->jmp, 1);
+    else
+        longjmp(((comp_t *) cinfo)->jmp, 1);
+}
+
+static void output_message(j_common_ptr cinfo) {
+    // Warnings are left out, like TJFLAG_STOPONWARNING not being set
+}
+
+tjhandle tjInitDecompress(void) {
+    decomp_t *decomp = calloc(1, sizeof(decomp_t));
+    if (decomp == NULL)
+        return NULL;
+
+    decomp->cinfo.err = jpeg_std_error(&decomp->jerr);
+    decomp->jerr.error_exit = error_exit;
+    decomp->jerr.output_message = output_message;
+
+    jpeg_create_decompress(&decomp->cinfo);
+
+    return decomp;
+}
+
+tjhandle tjInitCompress(void) {
+    comp_t *comp = calloc(1, sizeof(comp_t));
+    if (comp == NULL)
+        return NULL;
+
+    comp->cinfo.err = jpeg_std_error(&comp->jerr);
+    comp->jerr.error_exit = error_exit;
+    comp->jerr.output_message = output_message;
+
+    jpeg_create_compress(&comp->cinfo);
+
+    return comp;
+}
+
+// Both kinds start with the common fields, which say which one it is
+int tjDestroy(tjhandle handle) {
+    j_common_ptr cinfo = handle;
+    if (cinfo == NULL)
+        return -1;
+
+    jpeg_destroy(cinfo);
+    free(handle);
+
+    return 0;
+}
+
+int tjDecompressHeader3(tjhandle handle, const unsigned char *jpegBuf, unsigned long jpegSize, int *width, int *height, int *jpegSubsamp, int *jpegColorspace) {
+    decomp_t *decomp = handle;
+
+    if (setjmp(decomp->jmp)) {
+        jpeg_abort_decompress(&decomp->cinfo);
+        return -1;
+    }
+
+    jpeg_mem_src(&decomp->cinfo, jpegBuf, jpegSize);
+    jpeg_read_header(&decomp->cinfo, TRUE);
+
+    *width = decomp->cinfo.image_width;
+    *height = decomp->cinfo.image_height;
+    *jpegSubsamp = 0;
+    *jpegColorspace = decomp->cinfo.jpeg_color_space;
+
+    jpeg_abort_decompress(&decomp->cinfo);
+
+    return 0;
+}
+
+tjscalingfactor *tjGetScalingFactors(int *numScalingFactors) {
+    *numScalingFactors = sizeof(g_factors) / sizeof(g_factors[0]);
+
+    return g_factors;
+}
+
+int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf, unsigned long jpegSize, unsigned char *dstBuf, int width, int pitch, int height, int pixelFormat, int flags) {
+    decomp_t *decomp = handle;
+    struct jpeg_decompress_struct *cinfo = &decomp->cinfo;
+
+    if (pixelFormat != TJPF_BGRA) {
+        snprintf(g_err_str, sizeof(g_err_str), "Only TJPF_BGRA is supported");
+        return -1;
+    }
+
+    if (setjmp(decomp->jmp)) {
+        jpeg_abort_decompress(cinfo);
+        return -1;
+    }
+
+    jpeg_mem_src(cinfo, jpegBuf, jpegSize);
+    jpeg_read_header(cinfo, TRUE);
+
+    cinfo->out_color_space = JCS_EXT_BGRA;
+    cinfo->dct_method = (flags & TJFLAG_FASTDCT) ? JDCT_IFAST : JDCT_ISLOW;
+    cinfo->do_fancy_upsampling = !(flags & TJFLAG_FASTUPSAMPLE);
+
+    // The largest size that fits in width x height, the same as libturbojpeg picks
+    int num_factors = sizeof(g_factors) / sizeof(g_factors[0]);
+    int i = 0;
+
+    while (i < num_factors - 1 && (TJSCALED(cinfo->image_width, g_factors[i]) > width || TJSCALED(cinfo->image_height, g_factors[i]) > height))
+        i++;
+
+    cinfo->scale_num = g_factors[i].num;
+    cinfo->scale_denom = g_factors[i].denom;
+
+    jpeg_start_decompress(cinfo);
+
+    if (pitch == 0)
+        pitch = cinfo->output_width * 4;
+
+    while (cinfo->output_scanline < cinfo->output_height) {
+        JSAMPROW row = dstBuf + (size_t) cinfo->output_scanline * pitch;
+        jpeg_read_scanlines(cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(cinfo);
+
+    return 0;
+}
+
+int tjCompress2(tjhandle handle, const unsigned char *srcBuf, int width, int pitch, int height, int pixelFormat, unsigned char **jpegBuf, unsigned long *jpegSize, int jpegSubsamp, int jpegQual, int flags) {
+    comp_t *comp = handle;
+    struct jpeg_compress_struct *cinfo = &comp->cinfo;
+
+    if (pixelFormat != TJPF_BGRA || jpegSubsamp != TJSAMP_420) {
+        snprintf(g_err_str, sizeof(g_err_str), "Only TJPF_BGRA and TJSAMP_420 are supported");
+        return -1;
+    }
+
+    if (setjmp(comp->jmp)) {
+        jpeg_abort_compress(cinfo);
+        return -1;
+    }
+
+    *jpegBuf = NULL;
+    *jpegSize = 0;
+    jpeg_mem_dest(cinfo, jpegBuf, jpegSize);
+
+    cinfo->image_width = width;
+    cinfo->image_height = height;
+    cinfo->input_components = 4;
+    cinfo->in_color_space = JCS_EXT_BGRA;
+
+    // The defaults are baseline and 4:2:0
+    jpeg_set_defaults(cinfo);
+    jpeg_set_quality(cinfo, jpegQual, TRUE);
+    cinfo->dct_method = (flags & TJFLAG_FASTDCT) ? JDCT_IFAST : JDCT_ISLOW;
+
+    jpeg_start_compress(cinfo, TRUE);
+
+    if (pitch == 0)
+        pitch = width * 4;
+
+    while (cinfo->next_scanline < cinfo->image_height) {
+        JSAMPROW row = (JSAMPROW) srcBuf + (size_t) cinfo->next_scanline * pitch;
+        jpeg_write_scanlines(cinfo, &row, 1);
+    }
+
+    jpeg_finish_compress(cinfo);
+
+    return 0;
+}
+
+void tjFree(unsigned char *buffer) {
+    free(buffer);
+}
+
+char *tjGetErrorStr(void) {
+    return g_err_str;
+}
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "minizip/unzip.h"
+
+/*
+ * Reads the way minizip does: the central directory record again on every
+ * seek to a file, its local header on open, then the data through a 16KB
+ * buffer with a seek before every refill, inflated and CRC checked as it
+ * goes. No zip64, no encryption, nothing but stored and deflated members.
+ */
+
+#define UNZ_BUFSIZE 16384
+
+#define CENTRAL_SIG 0x02014b50
+#define LOCAL_SIG 0x04034b50
+#define END_SIG 0x06054b50
+
+#define CENTRAL_LEN 46
+#define LOCAL_LEN 30
+#define END_LEN 22
+
+typedef struct {
+    FILE *fp;
+
+    uLong num_entries;
+    uLong central_offset;
+
+    // The current file
+    uLong num_file;
+    uLong pos_in_central;
+    unz_file_info info;
+    uLong local_offset;
+
+    // The file open for reading
+    bool is_open;
+    z_stream stream;
+    uLong read_pos; // In the file, of the next compressed byte
+    uLong rest_compressed;
+    uLong rest_uncompressed;
+    uLong crc;
+    unsigned char buf[UNZ_BUFSIZE];
+} unz_t;
+
+static uLong get16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uLong get32(const unsigned char *p) {
+    return get16(p) | (get16(p + 2) << 16);
+}
+
+static int read_at(unz_t *unz, uLong pos, void *buf, size_t len) {
+    if (fseek(unz->fp, pos, SEEK_SET) != 0 || fread(buf, len, 1, unz->fp) != 1)
+        return UNZ_ERRNO;
+
+    return UNZ_OK;
+}
+
+static int read_central(unz_t *unz) {
+    unsigned char rec[CENTRAL_LEN];
+
+    if (read_at(unz, unz->pos_in_central, rec, sizeof(rec)) != UNZ_OK)
+        return UNZ_ERRNO;
+
+    if (get32(rec) != CENTRAL_SIG)
+        return UNZ_BADZIPFILE;
+
+    unz_file_info *info = &unz->info;
+    info->version = get16(rec + 4);
+    info->version_needed = get16(rec + 6);
+    info->flag = get16(rec + 8);
+    info->compression_method = get16(rec + 10);
+    info->dosDate = get32(rec + 12);
+    info->crc = get32(rec + 16);
+    info->compressed_size = get32(rec + 20);
+    info->uncompressed_size = get32(rec + 24);
+    info->size_filename = get16(rec + 28);
+    info->size_file_extra = get16(rec + 30);
+    info->size_file_comment = get16(rec + 32);
+    info->disk_num_start = get16(rec + 34);
+    info->internal_fa = get16(rec + 36);
+    info->external_fa = get32(rec + 38);
+
+    unz->local_offset = get32(rec + 42);
+
+    return UNZ_OK;
+}
+
+unzFile unzOpen(const char *path) {
+    unz_t *unz = calloc(1, sizeof(unz_t));
+    if (unz == NULL)
+        return NULL;
+
+    unz->fp = fopen(path, "rb");
+    if (unz->fp == NULL) {
+        free(unz);
+        return NULL;
+    }
+
+    // Only zips without a comment, so the end record is right at the end
+    unsigned char end[END_LEN];
+
+    if (fseek(unz->fp, -END_LEN, SEEK_END) != 0 || fread(end, sizeof(end), 1, unz->fp) != 1 || get32(end) != END_SIG) {
+        unzClose(unz);
+        return NULL;
+    }
+
+    unz->num_entries = get16(end + 10);
+    unz->central_offset = get32(end + 16);
+
+    if (unzGoToFirstFile(unz) != UNZ_OK && unz->num_entries != 0) {
+        unzClose(unz);
+        return NULL;
+    }
+
+    return unz;
+}
+
+int unzClose(unzFile file) {
+    unz_t *unz = file;
+    if (unz == NULL)
+        return UNZ_PARAMERROR;
+
+    if (unz->is_open)
+        unzCloseCurrentFile(unz);
+
+    fclose(unz->fp);
+    free(unz);
+
+    return UNZ_OK;
+}
+
+int unzGetGlobalInfo(unzFile file, unz_global_info *pglobal_info) {
+    unz_t *unz = file;
+
+    pglobal_info->number_entry = unz->num_entries;
+    pglobal_info->size_comment = 0;
+
+    return UNZ_OK;
+}
+
+int unzGoToFirstFile(unzFile file) {
+    unz_t *unz = file;
+
+    unz->num_file = 0;
+    unz->pos_in_central = unz->central_offset;
+
+    return read_central(unz);
+}
+
+int unzGoToNextFile(unzFile file) {
+    unz_t *unz = file;
+
+    if (unz->num_file + 1 >= unz->num_entries)
+        return UNZ_END_OF_LIST_OF_FILE;
+
+    unz->num_file++;
+    unz->pos_in_central += CENTRAL_LEN + unz->info.size_filename + unz->info.size_file_extra + unz->info.size_file_comment;
+
+    return read_central(unz);
+}
+
+int unzGetFilePos(unzFile file, unz_file_pos *file_pos) {
+    unz_t *unz = file;
+
+    file_pos->pos_in_zip_directory = unz->pos_in_central;
+    file_pos->num_of_file = unz->num_file;
+
+    return UNZ_OK;
+}
+
+int unzGoToFilePos(unzFile file, unz_file_pos *file_pos) {
+    unz_t *unz = file;
+
+    unz->num_file = file_pos->num_of_file;
+    unz->pos_in_central = file_pos->pos_in_zip_directory;
+
+    return read_central(unz);
+}
+
+// Like minizip, a name that doesn't fit is cut off without a terminator
+int unzGetCurrentFileInfo(unzFile file, unz_file_info *pfile_info, char *szFileName, uLong fileNameBufferSize, void *extraField, uLong extraFieldBufferSize, char *szComment, uLong commentBufferSize) {
+    unz_t *unz = file;
+
+    if (pfile_info != NULL)
+        *pfile_info = unz->info;
+
+    if (szFileName != NULL && fileNameBufferSize > 0) {
+        uLong len = unz->info.size_filename;
+
+        if (len < fileNameBufferSize)
+            szFileName[len] = '\0';
+        else
+            len = fileNameBufferSize;
+
+        if (len > 0 && read_at(unz, unz->pos_in_central + CENTRAL_LEN, szFileName, len) != UNZ_OK)
+            return UNZ_ERRNO;
+    }
+
+    return UNZ_OK;
+}
+
+int unzOpenCurrentFile(unzFile file) {
+    unz_t *unz = file;
+
+    if (unz->is_open)
+        unzCloseCurrentFile(unz);
+
+    unsigned char local[LOCAL_LEN];
+
+    if (read_at(unz, unz->local_offset, local, sizeof(local)) != UNZ_OK)
+        return UNZ_ERRNO;
+
+    if (get32(local) != LOCAL_SIG || (unz->info.compression_method != 0 && unz->info.compression_method != Z_DEFLATED))
+        return UNZ_BADZIPFILE;
+
+    memset(&unz->stream, 0, sizeof(z_stream));
+
+    if (unz->info.compression_method == Z_DEFLATED && inflateInit2(&unz->stream, -MAX_WBITS) != Z_OK)
+        return UNZ_INTERNALERROR;
+
+    unz->read_pos = unz->local_offset + LOCAL_LEN + get16(local + 26) + get16(local + 28);
+    unz->rest_compressed = unz->info.compressed_size;
+    unz->rest_uncompressed = unz->info.uncompressed_size;
+    unz->crc = crc32(0, NULL, 0);
+    unz->is_open = true;
+
+    return UNZ_OK;
+}
+
+int unzReadCurrentFile(unzFile file, void *buf, unsigned len) {
+    unz_t *unz = file;
+
+    if (!unz->is_open)
+        return UNZ_PARAMERROR;
+
+    if (len > unz->rest_uncompressed)
+        len = unz->rest_uncompressed;
+
+    unz->stream.next_out = buf;
+    unz->stream.avail_out = len;
+
+    unsigned done = 0;
+
+    while (unz->stream.avail_out > 0) {
+        if (unz->stream.avail_in == 0 && unz->rest_compressed > 0) {
+            uInt chunk = (unz->rest_compressed < UNZ_BUFSIZE) ? unz->rest_compressed : UNZ_BUFSIZE;
+
+            if (read_at(unz, unz->read_pos, unz->buf, chunk) != UNZ_OK)
+                return UNZ_ERRNO;
+
+            unz->read_pos += chunk;
+            unz->rest_compressed -= chunk;
+
+            unz->stream.next_in = unz->buf;
+            unz->stream.avail_in = chunk;
+        }
+
+        uInt copied;
+
+        if (unz->info.compression_method == 0) {
+            copied = (unz->stream.avail_in < unz->stream.avail_out) ? unz->stream.avail_in : unz->stream.avail_out;
+            if (copied == 0)
+                break;
+
+            memcpy(unz->stream.next_out, unz->stream.next_in, copied);
+
+            unz->stream.next_in += copied;
+            unz->stream.avail_in -= copied;
+            unz->stream.next_out += copied;
+            unz->stream.avail_out -= copied;
+        } else {
+            uInt before = unz->stream.avail_out;
+
+            int err = inflate(&unz->stream, Z_SYNC_FLUSH);
+            if (err != Z_OK && err != Z_STREAM_END)
+                return UNZ_BADZIPFILE;
+
+            copied = before - unz->stream.avail_out;
+
+            if (err == Z_STREAM_END && unz->stream.avail_out > 0 && copied == 0)
+                break;
+        }
+
+        unz->crc = crc32(unz->crc, unz->stream.next_out - copied, copied);
+        unz->rest_uncompressed -= copied;
+        done += copied;
+    }
+
+    return done;
+}
+
+int unzCloseCurrentFile(unzFile file) {
+    unz_t *unz = file;
+
+    if (!unz->is_open)
+        return UNZ_PARAMERROR;
+
+    if (unz->info.compression_method == Z_DEFLATED)
+        inflateEnd(&unz->stream);
+
+    unz->is_open = false;
+
+    if (unz->rest_uncompressed == 0 && unz->crc != unz->info.crc)
+        return UNZ_CRCERROR;
+
+    return UNZ_OK;
+}
\ No newline at end of file
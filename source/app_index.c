@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <sys/stat.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "app_index.h"
+#include "apps.h"
+#include "log.h"
+#include "util.h"
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 count;
+    u32 reserved;
+} index_header_t;
+
+typedef struct {
+    u64 size;
+    s64 mtime;
+    u64 icon_offset;
+    u64 icon_size;
+    u16 path_len;
+    u16 name_len;
+    u16 author_len;
+    u8 type;
+    u8 reserved;
+    char version[APP_VER_LEN];
+} __attribute__((packed)) index_disk_rec_t;
+
+typedef struct {
+    char *path; // Owns the name and author strings too, they're stored right after it
+    char *name;
+    char *author;
+    char version[APP_VER_LEN];
+
+    u64 size;
+    s64 mtime;
+    u64 icon_offset;
+    u64 icon_size;
+
+    u8 type;
+    bool seen;
+} index_rec_t;
+
+static index_rec_t *g_recs = NULL;
+static size_t g_recs_cap = 0;
+static size_t g_recs_len = 0;
+static bool g_dirty = false;
+static mtx_t g_mtx;
+
+static index_rec_t *find_slot(const char *path) {
+    return hash_find_slot(g_recs, sizeof(index_rec_t), g_recs_cap, path, strlen(path), NULL);
+}
+
+static index_rec_t *rec_ins(const char *path, size_t path_len, const char *name, size_t name_len, const char *author, size_t author_len) {
+    index_rec_t *recs = hash_grow(g_recs, sizeof(index_rec_t), &g_recs_cap, &g_recs_len, 256, NULL);
+    if (recs == NULL)
+        return NULL;
+
+    g_recs = recs;
+
+    char *strs = malloc(path_len + name_len + author_len + 3);
+    if (strs == NULL)
+        return NULL;
+
+    memcpy(strs, path, path_len);
+    strs[path_len] = '\0';
+
+    index_rec_t *rec = find_slot(strs);
+    if (rec->path != NULL)
+        free(rec->path);
+    else
+        g_recs_len++;
+
+    rec->path = strs;
+
+    rec->name = rec->path + path_len + 1;
+    memcpy(rec->name, name, name_len);
+    rec->name[name_len] = '\0';
+
+    rec->author = rec->name + name_len + 1;
+    memcpy(rec->author, author, author_len);
+    rec->author[author_len] = '\0';
+
+    return rec;
+}
+
+void app_index_init() {
+    mtx_init(&g_mtx, mtx_plain);
+}
+
+void app_index_exit() {
+    app_index_clear();
+    mtx_destroy(&g_mtx);
+}
+
+lv_res_t app_index_load() {
+    app_index_clear();
+
+    FILE *fp = fopen(APP_INDEX_PATH, "rb");
+    if (fp == NULL)
+        return LV_RES_INV;
+
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (file_size < (long) sizeof(index_header_t)) {
+        fclose(fp);
+        return LV_RES_INV;
+    }
+
+    u8 *buf = malloc(file_size);
+    if (buf == NULL) {
+        fclose(fp);
+        return LV_RES_INV;
+    }
+
+    // Read the whole thing at once, it's far cheaper than lots of small reads
+    if (fread(buf, file_size, 1, fp) != 1) {
+        free(buf);
+        fclose(fp);
+        return LV_RES_INV;
+    }
+
+    fclose(fp);
+
+    index_header_t *header = (index_header_t *) buf;
+    if (header->magic != APP_INDEX_MAGIC || header->version != APP_INDEX_VERSION) {
+        LV_LOG_WARN("Stale app index");
+        free(buf);
+        return LV_RES_INV;
+    }
+
+    u8 *p = buf + sizeof(index_header_t);
+    u8 *end = buf + file_size;
+
+    for (u32 i = 0; i < header->count; i++) {
+        if (p + sizeof(index_disk_rec_t) > end)
+            break;
+
+        index_disk_rec_t disk_rec;
+        memcpy(&disk_rec, p, sizeof(disk_rec));
+        p += sizeof(disk_rec);
+
+        char *path = (char *) p;
+        char *name = path + disk_rec.path_len;
+        char *author = name + disk_rec.name_len;
+        p = (u8 *) author + disk_rec.author_len;
+
+        if (p > end || disk_rec.path_len == 0)
+            break;
+
+        index_rec_t *rec = rec_ins(path, disk_rec.path_len, name, disk_rec.name_len, author, disk_rec.author_len);
+        if (rec == NULL)
+            break;
+
+        memcpy(rec->version, disk_rec.version, APP_VER_LEN);
+        rec->version[APP_VER_LEN - 1] = '\0';
+
+        rec->size = disk_rec.size;
+        rec->mtime = disk_rec.mtime;
+        rec->icon_offset = disk_rec.icon_offset;
+        rec->icon_size = disk_rec.icon_size;
+        rec->type = disk_rec.type;
+        rec->seen = false;
+    }
+
+    free(buf);
+
+    g_dirty = false;
+
+    return LV_RES_OK;
+}
+
+static lv_res_t write_index(FILE *fp, void *arg) {
+    index_header_t header = {
+        .magic = APP_INDEX_MAGIC,
+        .version = APP_INDEX_VERSION,
+        .count = *(size_t *) arg,
+    };
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+    for (size_t i = 0; ok && i < g_recs_cap; i++) {
+        index_rec_t *rec = &g_recs[i];
+        if (rec->path == NULL || !rec->seen)
+            continue;
+
+        index_disk_rec_t disk_rec = {
+            .size = rec->size,
+            .mtime = rec->mtime,
+            .icon_offset = rec->icon_offset,
+            .icon_size = rec->icon_size,
+            .path_len = strlen(rec->path),
+            .name_len = strlen(rec->name),
+            .author_len = strlen(rec->author),
+            .type = rec->type,
+        };
+        memcpy(disk_rec.version, rec->version, APP_VER_LEN);
+
+        ok = fwrite(&disk_rec, sizeof(disk_rec), 1, fp) == 1
+            && fwrite(rec->path, disk_rec.path_len, 1, fp) == 1
+            && (disk_rec.name_len == 0 || fwrite(rec->name, disk_rec.name_len, 1, fp) == 1)
+            && (disk_rec.author_len == 0 || fwrite(rec->author, disk_rec.author_len, 1, fp) == 1);
+    }
+
+    return ok ? LV_RES_OK : LV_RES_INV;
+}
+
+lv_res_t app_index_save() {
+    size_t num_seen = 0;
+    for (size_t i = 0; i < g_recs_cap; i++) {
+        if (g_recs[i].path != NULL && g_recs[i].seen)
+            num_seen++;
+    }
+
+    // Nothing was added, changed or removed, so the file on the SD card is still good
+    if (!g_dirty && num_seen == g_recs_len)
+        return LV_RES_OK;
+
+    if (save_file(APP_INDEX_PATH, write_index, &num_seen) != LV_RES_OK)
+        return LV_RES_INV;
+
+    g_dirty = false;
+
+    return LV_RES_OK;
+}
+
+void app_index_clear() {
+    for (size_t i = 0; i < g_recs_cap; i++)
+        free(g_recs[i].path);
+
+    free(g_recs);
+
+    g_recs = NULL;
+    g_recs_cap = 0;
+    g_recs_len = 0;
+    g_dirty = false;
+}
+
+lv_res_t app_index_get(app_entry_t *entry, struct stat *st) {
+    mtx_lock(&g_mtx);
+
+    if (g_recs_len == 0) {
+        mtx_unlock(&g_mtx);
+        return LV_RES_INV;
+    }
+
+    index_rec_t *rec = find_slot(entry->path);
+
+    if (rec->path == NULL || rec->size != st->st_size || rec->mtime != st->st_mtime || rec->type != entry->type) {
+        mtx_unlock(&g_mtx);
+        return LV_RES_INV;
+    }
+
+    entry->name = app_entry_intern(rec->name, strlen(rec->name));
+    entry->author = app_entry_intern(rec->author, strlen(rec->author));
+
+    strncpy(entry->version, rec->version, APP_VER_LEN - 1);
+    entry->version[APP_VER_LEN - 1] = '\0';
+
+    entry->icon_offset = rec->icon_offset;
+    entry->icon_size = rec->icon_size;
+
+    rec->seen = true;
+
+    mtx_unlock(&g_mtx);
+
+    return LV_RES_OK;
+}
+
+void app_index_put(app_entry_t *entry, struct stat *st) {
+    mtx_lock(&g_mtx);
+
+    index_rec_t *rec = rec_ins(entry->path, strlen(entry->path), entry->name, strlen(entry->name), entry->author, strlen(entry->author));
+    if (rec == NULL) {
+        mtx_unlock(&g_mtx);
+        return;
+    }
+
+    strncpy(rec->version, entry->version, APP_VER_LEN - 1);
+    rec->version[APP_VER_LEN - 1] = '\0';
+
+    rec->size = st->st_size;
+    rec->mtime = st->st_mtime;
+    rec->icon_offset = entry->icon_offset;
+    rec->icon_size = entry->icon_size;
+    rec->type = entry->type;
+    rec->seen = true;
+
+    g_dirty = true;
+
+    mtx_unlock(&g_mtx);
+}
+
+lv_res_t app_index_get_dir(const char *path, struct stat *st, char *out_app_name, size_t size) {
+    // Some file systems don't keep a directory mtime, those always get listed
+    if (st->st_mtime == 0)
+        return LV_RES_INV;
+
+    mtx_lock(&g_mtx);
+
+    if (g_recs_len == 0) {
+        mtx_unlock(&g_mtx);
+        return LV_RES_INV;
+    }
+
+    index_rec_t *rec = find_slot(path);
+
+    if (rec->path == NULL || rec->type != APP_INDEX_DIR_TYPE || rec->mtime != st->st_mtime || rec->size != st->st_size) {
+        mtx_unlock(&g_mtx);
+        return LV_RES_INV;
+    }
+
+    strncpy(out_app_name, rec->name, size - 1);
+    out_app_name[size - 1] = '\0';
+
+    rec->seen = true;
+
+    mtx_unlock(&g_mtx);
+
+    return LV_RES_OK;
+}
+
+void app_index_put_dir(const char *path, struct stat *st, const char *app_name) {
+    mtx_lock(&g_mtx);
+
+    index_rec_t *rec = rec_ins(path, strlen(path), app_name, strlen(app_name), "", 0);
+    if (rec == NULL) {
+        mtx_unlock(&g_mtx);
+        return;
+    }
+
+    rec->version[0] = '\0';
+
+    rec->size = st->st_size;
+    rec->mtime = st->st_mtime;
+    rec->icon_offset = 0;
+    rec->icon_size = 0;
+    rec->type = APP_INDEX_DIR_TYPE;
+    rec->seen = true;
+
+    g_dirty = true;
+
+    mtx_unlock(&g_mtx);
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <sys/stat.h>
+#include <lvgl/lvgl.h>
+
+#include "apps.h"
+#include "settings.h"
+
+#define APP_INDEX_PATH SETTINGS_DIR "/apps.idx"
+
+#define APP_INDEX_MAGIC 0x49434248 // "HBCI"
+#define APP_INDEX_VERSION 1
+
+#define APP_INDEX_DIR_TYPE 0xff
+
+// The lookups below may be used from several scan workers at once
+void app_index_init();
+void app_index_exit();
+
+lv_res_t app_index_load();
+lv_res_t app_index_save();
+void app_index_clear();
+
+/*
+ * Fills in the metadata of the entry if the index has a
+ * record for its path that matches the size and mtime in st.
+ */
+lv_res_t app_index_get(app_entry_t *entry, struct stat *st);
+void app_index_put(app_entry_t *entry, struct stat *st);
+
+/*
+ * Directory records remember which app a subdirectory of the app directory
+ * resolved to, so it doesn't have to be listed again while its mtime stays
+ * the same. An empty app name means it had none.
+ */
+lv_res_t app_index_get_dir(const char *path, struct stat *st, char *out_app_name, size_t size);
+void app_index_put_dir(const char *path, struct stat *st, const char *app_name);
\ No newline at end of file
@@ -1,21 +1,33 @@
 #include <stdio.h>
-#include <dirent.h>
+#include <stdlib.h>
 #include <limits.h>
 #include <string.h>
 #include <unistd.h>
-#include <minizip/unzip.h>
+#include <sys/stat.h>
 #include <libconfig.h>
 #include <lvgl/lvgl.h>
 #include <switch.h>
 
 #include "apps.h"
+#include "app_index.h"
+#include "decoder.h"
+#include "dir_iter.h"
+#include "favorites.h"
+#include "icon_store.h"
+#include "scan_pool.h"
+#include "str_arena.h"
+#include "thumbs.h"
 #include "log.h"
 #include "util.h"
+#include "zip_reader.h"
 #include "main.h"
+#include "settings.h"
 #include "theme.h"
 
-static AppEntryType get_app_type(char *path) {
-    char *ext = get_ext(path);
+static str_arena_t g_strs;
+
+static AppEntryType get_app_type(const char *path) {
+    char *ext = get_ext((char *) path);
 
     if (strcasecmp(ext, "nro") == 0)
         return AppEntryType_homebrew;
@@ -26,21 +38,116 @@ static AppEntryType get_app_type(char *path) {
     return AppEntryType_none;
 }
 
-void app_entry_init_base(app_entry_t *entry, char *path) {
-    strncpy(entry->path, path, PATH_MAX);
-    entry->path[PATH_MAX] = '\0';
+/*
+ * Reads the NRO header and asset header in one pass over the file and
+ * records the icon location on the entry, so later icon loads can seek
+ * straight to it. If nacp isn't NULL the NACP is read as well.
+ */
+static lv_res_t nro_read_assets(FILE *fp, app_entry_t *entry, NacpStruct *nacp) {
+    struct {
+        NroStart start;
+        NroHeader header;
+    } head;
+
+    // The start and header are contiguous so grab both at once
+    fseek(fp, 0, SEEK_SET);
+    if (fread(&head, sizeof(head), 1, fp) != 1) {
+        LV_LOG_WARN("Bad header read");
+        return LV_RES_INV;
+    }
+
+    NroAssetHeader asset_header;
+
+    fseek(fp, head.header.size, SEEK_SET);
+    if (fread(&asset_header, sizeof(asset_header), 1, fp) != 1 || asset_header.magic != NROASSETHEADER_MAGIC) {
+        LV_LOG_WARN("Bad asset header read");
+        return LV_RES_INV;
+    }
+
+    entry->icon_offset = head.header.size + asset_header.icon.offset;
+    entry->icon_size = asset_header.icon.size;
+
+    if (nacp == NULL)
+        return LV_RES_OK;
+
+    if (asset_header.nacp.size < sizeof(NacpStruct)) {
+        LV_LOG_WARN("Bad nacp size");
+        return LV_RES_INV;
+    }
+
+    // Skip the seek when the NACP directly follows the asset header
+    if (asset_header.nacp.offset != sizeof(asset_header))
+        fseek(fp, head.header.size + asset_header.nacp.offset, SEEK_SET);
+
+    if (fread(nacp, sizeof(NacpStruct), 1, fp) != 1) {
+        LV_LOG_WARN("Bad nacp read");
+        return LV_RES_INV;
+    }
+
+    return LV_RES_OK;
+}
+
+lv_res_t app_entries_init() {
+    str_arena_init(&g_strs);
+    app_index_init();
+    thumbs_init();
+    icon_store_init(THUMB_SIZE);
+
+    return favorites_init();
+}
+
+void app_entries_exit() {
+    favorites_exit();
+    icon_store_exit();
+    thumbs_exit();
+    app_index_exit();
+    str_arena_exit(&g_strs);
+}
+
+const char *app_entry_intern(const char *str, size_t len) {
+    const char *ret = str_arena_intern(&g_strs, str, len);
+
+    // Only happens when out of memory, keep the entry usable anyway
+    if (ret == NULL)
+        return "";
+
+    return ret;
+}
+
+void app_entry_init_base(app_entry_t *entry, const char *path) {
+    entry->path = app_entry_intern(path, strlen(path));
 
-    entry->args[0] = '\0';
-    app_entry_add_arg(entry, path);
+    entry->name = "";
+    entry->author = "";
+    entry->version[0] = '\0';
 
-    char star_path[PATH_MAX + 1];
-    app_entry_get_star_path(entry, star_path);
-    entry->starred = is_file(star_path);
+    entry->starred = favorites_has(entry->path);
+
+    // Stars used to be hidden files next to the apps, they're only looked for until the favorites file exists
+    if (!entry->starred && favorites_migrating()) {
+        char star_path[PATH_MAX + 1];
+        app_entry_get_star_path(entry->path, star_path);
+
+        if (is_file(star_path)) {
+            favorites_set(entry->path, true);
+            entry->starred = true;
+        }
+    }
 
     entry->type = get_app_type(path);
+
+    entry->icon_offset = 0;
+    entry->icon_size = 0;
+
+    entry->file_size = 0;
+    entry->file_mtime = 0;
+
+    entry->icon.data = NULL;
+    entry->icon_small.data = NULL;
 }
 
-lv_res_t app_entry_init_icon(app_entry_t *entry) {
+// The bytes come from the icon store, this also runs on the icon loader threads
+static lv_res_t load_icon(app_entry_t *entry) {
     void *data = NULL;
     u32 size = 0;
 
@@ -52,35 +159,24 @@ lv_res_t app_entry_init_icon(app_entry_t *entry) {
                 return LV_RES_INV;
             }
 
-            NroHeader header;
-            NroAssetHeader asset_header;
-
-            fseek(fp, sizeof(NroStart), SEEK_SET);
-            if (fread(&header, sizeof(header), 1, fp) != 1) {
-                LV_LOG_WARN("Bad header read");
+            // The icon location may already be known from the app index or an earlier load
+            if ((entry->icon_offset == 0 || entry->icon_size == 0) && nro_read_assets(fp, entry, NULL) != LV_RES_OK) {
                 fclose(fp);
                 return LV_RES_INV;
             }
 
-            fseek(fp, header.size, SEEK_SET);
-            if (fread(&asset_header, sizeof(asset_header), 1, fp) != 1) {
-                LV_LOG_WARN("Bad asset header read");
-                fclose(fp);
-                return LV_RES_INV;
-            }
-
-            size = asset_header.icon.size;
-            data = lv_mem_alloc(size);
+            size = entry->icon_size;
+            data = icon_store_alloc(size);
             if (data == NULL) {
                 LV_LOG_WARN("Bad icon alloc");
                 fclose(fp);
                 return LV_RES_INV;
             }
 
-            fseek(fp, header.size + asset_header.icon.offset, SEEK_SET);
+            fseek(fp, entry->icon_offset, SEEK_SET);
             if (fread((u8 *) data, size, 1, fp) != 1) {
                 LV_LOG_WARN("Bad icon read");
-                lv_mem_free(data);
+                icon_store_release(data);
                 fclose(fp);
                 return LV_RES_INV;
             }
@@ -89,44 +185,41 @@ lv_res_t app_entry_init_icon(app_entry_t *entry) {
         } break;
 
         case AppEntryType_theme: {
-            unzFile zf = unzOpen(entry->path);
-            if (zf == NULL)
-                return LV_RES_INV;
+            // Where the icon sits in the central directory is usually known from the scan, then the zip needn't be indexed
+            bool known = entry->icon_offset != 0 && entry->icon_size != 0;
 
-            if (unzLocateFile(zf, "icon.jpg", 0) != UNZ_OK) {
-                unzClose(zf);
+            zip_reader_t zip;
+            if (zip_reader_open(&zip, entry->path, !known) != LV_RES_OK)
                 return LV_RES_INV;
-            }
 
-            if (unzOpenCurrentFile(zf) != UNZ_OK) {
-                unzClose(zf);
-                return LV_RES_INV;
-            }
+            zip_member_t known_member = {
+                .pos = {.pos_in_zip_directory = entry->icon_offset, .num_of_file = 0},
+                .size = entry->icon_size,
+            };
 
-            unz_file_info file_info;
-            if (unzGetCurrentFileInfo(zf, &file_info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) {
-                unzCloseCurrentFile(zf);
-                unzClose(zf);
+            const zip_member_t *member = known ? &known_member : zip_reader_find(&zip, "icon.jpg");
+            if (member == NULL) {
+                zip_reader_close(&zip);
                 return LV_RES_INV;
             }
 
-            size = file_info.uncompressed_size;
-            data = lv_mem_alloc(size);
+            size = member->size;
+            data = icon_store_alloc(size);
             if (data == NULL) {
-                unzCloseCurrentFile(zf);
-                unzClose(zf);
+                zip_reader_close(&zip);
                 return LV_RES_INV;
             }
 
-            if (unzReadCurrentFile(zf, data, size) < size) {
-                lv_mem_free(data);
-                unzCloseCurrentFile(zf);
-                unzClose(zf);
+            if (zip_reader_read(&zip, member, data) != LV_RES_OK) {
+                icon_store_release(data);
+                zip_reader_close(&zip);
                 return LV_RES_INV;
             }
 
-            unzCloseCurrentFile(zf);
-            unzClose(zf);
+            entry->icon_offset = member->pos.pos_in_zip_directory;
+            entry->icon_size = member->size;
+
+            zip_reader_close(&zip);
         } break;
 
         default:
@@ -139,18 +232,105 @@ lv_res_t app_entry_init_icon(app_entry_t *entry) {
         .header.h = APP_ICON_H,
         .data_size = size,
         .header.cf = LV_IMG_CF_RAW,
-        .data = data,
+        .data = icon_store_intern(data),
     };
 
-    entry->icon_small = entry->icon;
-    entry->icon_small.header.w = APP_ICON_SMALL_W;
-    entry->icon_small.header.h = APP_ICON_SMALL_H;
+    return LV_RES_OK;
+}
+
+lv_res_t app_entry_init_icon(app_entry_t *entry) {
+    if (entry->icon.data != NULL)
+        return LV_RES_OK;
+
+    if (load_icon(entry) != LV_RES_OK)
+        return LV_RES_INV;
+
+    // Without a thumbnail the small icon is the same JPEG drawn smaller
+    if (entry->icon_small.data == NULL) {
+        entry->icon_small = entry->icon;
+        entry->icon_small.header.w = APP_ICON_SMALL_W;
+        entry->icon_small.header.h = APP_ICON_SMALL_H;
+
+        decoderCacheLinkMip(&entry->icon_small, &entry->icon);
+    }
 
     return LV_RES_OK;
 }
 
+u8 *app_entry_decode_small_icon(app_entry_t *entry, bool *preview) {
+    bool loaded = entry->icon.data == NULL;
+
+    if (loaded && load_icon(entry) != LV_RES_OK)
+        return NULL;
+
+    // Another app with the same icon may have been decoded already, that's as good as a full decode
+    u8 *data = icon_store_find_decoded(entry->icon.data);
+
+    if (data != NULL) {
+        *preview = false;
+    } else if ((data = icon_store_alloc(THUMB_SIZE)) != NULL) {
+        lv_res_t res;
+        if (*preview)
+            res = decoderDecodePreviewTo(&entry->icon, data, APP_ICON_SMALL_W, APP_ICON_SMALL_H);
+        else
+            res = decoderDecodeTo(&entry->icon, data, APP_ICON_SMALL_W, APP_ICON_SMALL_H);
+
+        if (res != LV_RES_OK) {
+            icon_store_release(data);
+            data = NULL;
+        } else if (!*preview) {
+            data = icon_store_add_decoded(data, entry->icon.data);
+        }
+    }
+
+    if (loaded && !*preview) {
+        icon_store_release(entry->icon.data);
+        entry->icon.data = NULL;
+    }
+
+    return data;
+}
+
+void app_entry_set_small_icon(app_entry_t *entry, u8 *data) {
+    // Whatever was drawn as the small icon before mustn't be drawn from again
+    if (entry->icon_small.data != NULL) {
+        if (entry->icon_small.header.cf == LV_IMG_CF_TRUE_COLOR) {
+            lv_img_cache_invalidate_src(&entry->icon_small);
+            icon_store_release(entry->icon_small.data);
+        } else {
+            decoderCacheDrop(&entry->icon_small);
+        }
+    }
+
+    entry->icon_small = (lv_img_dsc_t) {
+        .header.always_zero = 0,
+        .header.w = APP_ICON_SMALL_W,
+        .header.h = APP_ICON_SMALL_H,
+        .data_size = THUMB_SIZE,
+        .header.cf = LV_IMG_CF_TRUE_COLOR,
+        .data = data,
+    };
+}
+
 void app_entry_free_icon(app_entry_t *entry) {
-    lv_mem_free((void *) entry->icon.data);
+    // Thumbnails have their own buffer, LVGL mustn't keep drawing from it
+    if (entry->icon_small.data != NULL && entry->icon_small.header.cf == LV_IMG_CF_TRUE_COLOR) {
+        lv_img_cache_invalidate_src(&entry->icon_small);
+        icon_store_release(entry->icon_small.data);
+    }
+
+    icon_store_release(entry->icon.data);
+
+    entry->icon.data = NULL;
+    entry->icon_small.data = NULL;
+}
+
+void app_entry_free(app_entry_t *entry) {
+    decoderCacheDrop(&entry->icon);
+    decoderCacheDrop(&entry->icon_small);
+
+    app_entry_free_icon(entry);
+    free(entry);
 }
 
 lv_res_t app_entry_init_info(app_entry_t *entry) {
@@ -162,37 +342,15 @@ lv_res_t app_entry_init_info(app_entry_t *entry) {
                 return LV_RES_INV;
             }
 
-            NroHeader header;
-            NroAssetHeader asset_header;
-
-            fseek(fp, sizeof(NroStart), SEEK_SET);
-            if (fread(&header, sizeof(header), 1, fp) != 1) {
-                LV_LOG_WARN("Bad header read\n");
-                fclose(fp);
-                return LV_RES_INV;
-            }
-
-            fseek(fp, header.size, SEEK_SET);
-            if (fread(&asset_header, sizeof(asset_header), 1, fp) != 1) {
-                LV_LOG_WARN("Bad asset header read\n");
-                fclose(fp);
-                return LV_RES_INV;
-            }
-
             NacpStruct nacp;
 
-            fseek(fp, header.size + asset_header.nacp.offset, SEEK_SET);
-            if (fread(&nacp, sizeof(nacp), 1, fp) != 1) {
-                LV_LOG_WARN("Bad nacp read\n");
+            if (nro_read_assets(fp, entry, &nacp) != LV_RES_OK) {
                 fclose(fp);
                 return LV_RES_INV;
             }
 
-            strncpy(entry->name, nacp.lang[0].name, APP_NAME_LEN - 1);
-            entry->name[APP_NAME_LEN - 1] = '\0';
-
-            strncpy(entry->author, nacp.lang[0].author, APP_AUTHOR_LEN - 1);
-            entry->author[APP_AUTHOR_LEN - 1] = '\0';
+            entry->name = app_entry_intern(nacp.lang[0].name, strnlen(nacp.lang[0].name, sizeof(nacp.lang[0].name)));
+            entry->author = app_entry_intern(nacp.lang[0].author, strnlen(nacp.lang[0].author, sizeof(nacp.lang[0].author)));
 
             strncpy(entry->version, nacp.display_version, APP_VER_LEN - 1);
             entry->version[APP_VER_LEN - 1] = '\0';
@@ -201,38 +359,32 @@ lv_res_t app_entry_init_info(app_entry_t *entry) {
         } break;
 
         case AppEntryType_theme: {
-            unzFile zf = unzOpen(entry->path);
-            if (zf == NULL)
+            zip_reader_t zip;
+            if (zip_reader_open(&zip, entry->path, true) != LV_RES_OK)
                 return LV_RES_INV;
 
-            if (unzLocateFile(zf, "info.cfg", 0) != UNZ_OK) {
-                unzClose(zf);
+            const zip_member_t *member = zip_reader_find(&zip, "info.cfg");
+            if (member == NULL) {
+                zip_reader_close(&zip);
                 return LV_RES_INV;
             }
 
-            if (unzOpenCurrentFile(zf) != UNZ_OK) {
-                unzClose(zf);
+            char cfg_str[member->size + 1];
+            if (zip_reader_read(&zip, member, cfg_str) != LV_RES_OK) {
+                zip_reader_close(&zip);
                 return LV_RES_INV;
             }
 
-            unz_file_info file_info;
-            if (unzGetCurrentFileInfo(zf, &file_info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) {
-                unzCloseCurrentFile(zf);
-                unzClose(zf);
-                return LV_RES_INV;
-            }
+            cfg_str[member->size] = '\0';
 
-            char cfg_str[file_info.uncompressed_size + 1];
-            if (unzReadCurrentFile(zf, cfg_str, file_info.uncompressed_size) < file_info.uncompressed_size) {
-                unzCloseCurrentFile(zf);
-                unzClose(zf);
-                return LV_RES_INV;
+            // Saves indexing the zip again when the icon is loaded
+            const zip_member_t *icon_member = zip_reader_find(&zip, "icon.jpg");
+            if (icon_member != NULL) {
+                entry->icon_offset = icon_member->pos.pos_in_zip_directory;
+                entry->icon_size = icon_member->size;
             }
 
-            unzCloseCurrentFile(zf);
-            unzClose(zf);
-
-            cfg_str[file_info.uncompressed_size] = '\0';
+            zip_reader_close(&zip);
 
             config_t cfg;
 
@@ -254,15 +406,13 @@ lv_res_t app_entry_init_info(app_entry_t *entry) {
                 config_destroy(&cfg);
                 return LV_RES_INV;
             }
-            strncpy(entry->name, tmp_str, APP_NAME_LEN - 1);
-            entry->name[APP_NAME_LEN - 1] = '\0';
+            entry->name = app_entry_intern(tmp_str, strnlen(tmp_str, APP_NAME_LEN - 1));
 
             if (config_setting_lookup_string(info, "author", &tmp_str) != CONFIG_TRUE) {
                 config_destroy(&cfg);
                 return LV_RES_INV;
             }
-            strncpy(entry->author, tmp_str, APP_AUTHOR_LEN - 1);
-            entry->author[APP_AUTHOR_LEN - 1] = '\0';
+            entry->author = app_entry_intern(tmp_str, strnlen(tmp_str, APP_AUTHOR_LEN - 1));
 
             if (config_setting_lookup_string(info, "version", &tmp_str) != CONFIG_TRUE) {
                 config_destroy(&cfg);
@@ -279,46 +429,34 @@ lv_res_t app_entry_init_info(app_entry_t *entry) {
     return LV_RES_OK;
 }
 
-void app_entry_get_star_path(app_entry_t *entry, char *out_path) {
-    strncpy(out_path, entry->path, PATH_MAX);
+void app_entry_get_star_path(const char *path, char *out_path) {
+    strncpy(out_path, path, PATH_MAX);
     out_path[PATH_MAX] = '\0';
 
     char *out_name = get_name(out_path);
     size_t out_name_len = strlen(out_name);
 
     strncpy(out_name, ".", PATH_MAX - out_name_len);
-    strncpy(out_name + 1, get_name(entry->path), PATH_MAX - out_name_len - 1);
+    strncpy(out_name + 1, get_name((char *) path), PATH_MAX - out_name_len - 1);
     out_path[PATH_MAX] = '\0';
 
     strcat(out_name, ".star");
 }
 
 lv_res_t app_entry_set_star(app_entry_t *entry, bool star) {
-    char star_path[PATH_MAX + 1];
-    app_entry_get_star_path(entry, star_path);
-
-    if (star) {
-        FILE *fp = fopen(star_path, "w");
-
-        if (fp == NULL)
-            return LV_RES_INV;
-
-        fclose(fp);
-    } else {
-        if (remove(star_path) != 0)
-            return LV_RES_INV;
-    }
+    favorites_set(entry->path, star);
 
     entry->starred = star;
+    app_entry_update_sort_key(entry);
 
     return LV_RES_OK;
 }
 
 
 lv_res_t app_entry_delete(app_entry_t *entry) {
-    app_entry_set_star(entry, false); // Try to remove star file
+    app_entry_set_star(entry, false);
 
-    if (get_name(entry->path) == entry->path + sizeof(APP_DIR)) { // Is just a file under the app directory
+    if (get_name((char *) entry->path) == entry->path + sizeof(APP_DIR)) { // Is just a file under the app directory
         if (remove(entry->path) != 0)
             return LV_RES_INV;
     } else {
@@ -338,40 +476,53 @@ lv_res_t app_entry_delete(app_entry_t *entry) {
     return LV_RES_OK;
 }
 
-lv_res_t app_entry_add_arg(app_entry_t *entry, char *arg) {
-    size_t new_arg_len = strlen(entry->args) + strlen(arg) + 3;
+lv_res_t app_args_add(char *args, const char *arg) {
+    size_t new_arg_len = strlen(args) + strlen(arg) + 3;
 
-    if (entry->args[0] == '\0')
+    if (args[0] == '\0')
         new_arg_len--;
 
     if (new_arg_len >= APP_ARGS_LEN)
         return LV_RES_INV;
 
-    if (entry->args[0] != '\0')
-        strcat(entry->args, " ");
+    if (args[0] != '\0')
+        strcat(args, " ");
 
-    strcat(entry->args, "\"");
-    strcat(entry->args, arg);
-    strcat(entry->args, "\"");
+    strcat(args, "\"");
+    strcat(args, arg);
+    strcat(args, "\"");
 
     return LV_RES_OK;
 }
 
-lv_res_t app_entry_load(app_entry_t *entry) {
+lv_res_t app_entry_load(app_entry_t *entry, const char *args) {
     switch (entry->type) {
         case AppEntryType_homebrew: {
-            if (R_FAILED(envSetNextLoad(entry->path, entry->args)))
+            // Only built now so entries don't have to carry them around
+            char full_args[APP_ARGS_LEN];
+            full_args[0] = '\0';
+
+            if (app_args_add(full_args, entry->path) != LV_RES_OK)
+                return LV_RES_INV;
+
+            if (args != NULL && args[0] != '\0') {
+                if (strlen(full_args) + 1 + strlen(args) >= APP_ARGS_LEN)
+                    return LV_RES_INV;
+
+                strcat(full_args, " ");
+                strcat(full_args, args);
+            }
+
+            if (R_FAILED(envSetNextLoad(entry->path, full_args)))
                 return LV_RES_INV;
 
             stop_main_loop();
         } break;
 
         case AppEntryType_theme: {
-            lv_res_t res = copy(THEME_PATH, entry->path);
+            lv_res_t res = theme_install(entry->path);
             if (res != LV_RES_OK)
                 return res;
-
-            do_theme_reset();
         } break;
 
         default:
@@ -381,67 +532,157 @@ lv_res_t app_entry_load(app_entry_t *entry) {
     return LV_RES_OK;
 }
 
-lv_res_t app_entry_ll_ins(lv_ll_t *ll, char *path) {
-    app_entry_t *entry = lv_ll_ins_tail(ll);
+// st can be NULL when the caller hasn't stat'ed the path already
+static app_entry_t *scan_app(char *path, struct stat *st) {
+    struct stat tmp_st;
+    if (st == NULL) {
+        if (stat(path, &tmp_st) != 0)
+            return NULL;
+
+        st = &tmp_st;
+    }
+
+    // Scans may run off the UI thread, so stay away from the LVGL allocator
+    app_entry_t *entry = malloc(sizeof(app_entry_t));
+    if (entry == NULL)
+        return NULL;
+
     app_entry_init_base(entry, path);
 
-    lv_res_t res = app_entry_init_info(entry);
-    if (res != LV_RES_OK) {
-        lv_ll_rem(ll, entry);
-        return res;
+    entry->file_size = st->st_size;
+    entry->file_mtime = st->st_mtime;
+
+    if (app_index_get(entry, st) != LV_RES_OK) {
+        if (app_entry_init_info(entry) != LV_RES_OK) {
+            free(entry);
+            return NULL;
+        }
+
+        app_index_put(entry, st);
     }
 
-    app_entry_t *tmp_entry;
-    LV_LL_READ(*ll, tmp_entry) {
-        if (!entry->starred && tmp_entry->starred)
+    app_entry_update_sort_key(entry);
+
+    return entry;
+}
+
+// Returns the first good app in a subdirectory of the app directory, and remembers it for the next scan
+static app_entry_t *scan_app_dir(char *dir_path, struct stat *dir_st) {
+    dir_iter_t it;
+    if (dir_iter_open(&it, dir_path) != LV_RES_OK)
+        return NULL;
+
+    app_entry_t *entry = NULL;
+
+    dir_iter_entry_t *dir_entry;
+    while ((dir_entry = dir_iter_next(&it))) {
+        if (dir_entry->is_dir || get_app_type(dir_entry->name) == AppEntryType_none)
             continue;
 
-        if ((entry->starred && !tmp_entry->starred) || strcasecmp(entry->name, tmp_entry->name) < 0) {
-            lv_ll_move_before(ll, entry, tmp_entry);
+        char path[PATH_MAX + 1];
+        path[0] = '\0';
+        snprintf(path, sizeof(path), "%s/%s", dir_path, dir_entry->name);
+
+        entry = scan_app(path, NULL);
+        if (entry != NULL)
             break;
-        }
     }
 
-    return LV_RES_OK;
+    dir_iter_close(&it);
+
+    app_index_put_dir(dir_path, dir_st, (entry != NULL) ? get_name((char *) entry->path) : "");
+
+    return entry;
 }
 
-lv_res_t app_entry_ll_init(lv_ll_t *ll) {
-    DIR *app_dp = opendir(APP_DIR);
-    if (app_dp == NULL)
+// Looks at one entry of the app directory, which is either an app or a subdirectory holding one
+static app_entry_t *scan_dir_entry(const char *name, bool is_dir) {
+    char tmp_path[PATH_MAX + 1];
+    tmp_path[0] = '\0';
+    snprintf(tmp_path, sizeof(tmp_path), "%s/%s", APP_DIR, name);
+
+    // The index wants the mtime, which a listing doesn't have
+    struct stat st;
+    if (stat(tmp_path, &st) != 0)
+        return NULL;
+
+    if (!is_dir)
+        return scan_app(tmp_path, &st);
+
+    app_entry_t *entry = NULL;
+
+    char app_name[PATH_MAX + 1];
+    if (app_index_get_dir(tmp_path, &st, app_name, sizeof(app_name)) == LV_RES_OK) {
+        // Unchanged and still without an app
+        if (app_name[0] == '\0')
+            return NULL;
+
+        char path[PATH_MAX + 1];
+        snprintf(path, sizeof(path), "%s/%s", tmp_path, app_name);
+
+        entry = scan_app(path, NULL);
+    }
+
+    // The app can still have been replaced in place, so list it again if it's not good anymore
+    if (entry == NULL)
+        entry = scan_app_dir(tmp_path, &st);
+
+    return entry;
+}
+
+static void *scan_job(const scan_job_t *job) {
+    return scan_dir_entry(job->name, job->is_dir);
+}
+
+typedef struct {
+    app_entry_scan_cb_t cb;
+    void *arg;
+} scan_ctx_t;
+
+static bool scan_done(void *result, void *arg) {
+    scan_ctx_t *ctx = arg;
+    return ctx->cb(result, ctx->arg);
+}
+
+lv_res_t app_entry_scan(app_entry_scan_cb_t cb, void *arg) {
+    u64 start_tick = armGetSystemTick();
+
+    dir_iter_t it;
+    if (dir_iter_open(&it, APP_DIR) != LV_RES_OK)
         return LV_RES_INV;
 
-    lv_ll_init(ll, sizeof(app_entry_t));
+    scan_queue_t queue;
+    scan_queue_init(&queue);
 
-    struct dirent *ep;
-    while ((ep = readdir(app_dp))) {
-        char tmp_path[PATH_MAX + 1];
-        tmp_path[0] = '\0';
-        snprintf(tmp_path, sizeof(tmp_path), "%s/%s", APP_DIR, ep->d_name);
+    // Files that can't be apps are dropped here by their name alone
+    dir_iter_entry_t *dir_entry;
+    while ((dir_entry = dir_iter_next(&it))) {
+        if (!dir_entry->is_dir && get_app_type(dir_entry->name) == AppEntryType_none)
+            continue;
 
-        if (is_dir(tmp_path)) {
-            DIR *dp = opendir(tmp_path);
-            if (dp == NULL)
-                continue;
+        if (scan_queue_add(&queue, dir_entry->name, dir_entry->is_dir) != LV_RES_OK)
+            break;
+    }
 
-            while ((ep = readdir(dp))) {
-                char path[PATH_MAX + 1];
-                path[0] = '\0';
-                snprintf(path, sizeof(path), "%s/%s", tmp_path, ep->d_name);
+    dir_iter_close(&it);
 
-                if (get_app_type(path) != AppEntryType_none) {
-                    if (app_entry_ll_ins(ll, path) != LV_RES_OK)
-                        continue;
+    app_index_load();
 
-                    break;
-                }
-            }
+    scan_ctx_t ctx = {.cb = cb, .arg = arg};
+    lv_res_t res = scan_pool_run(&queue, curr_settings()->scan_threads, scan_job, scan_done, &ctx);
 
-            closedir(dp);
-        } else if (get_app_type(tmp_path) != AppEntryType_none) {
-            app_entry_ll_ins(ll, tmp_path);
-        }
+    int num_jobs = queue.len;
+    scan_queue_clear(&queue);
+
+    // A cut short scan hasn't seen every app, so saving would drop good records
+    if (res == LV_RES_OK) {
+        app_index_save();
+        favorites_migration_done();
     }
 
-    closedir(app_dp);
-    return LV_RES_OK;
+    app_index_clear();
+
+    logPrintf("app_entry_scan: %d entries with scan_threads %d in %lluus\n", num_jobs, curr_settings()->scan_threads, armTicksToNs(armGetSystemTick() - start_tick) / 1000);
+
+    return res;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <lvgl/lvgl.h>
 #include <limits.h>
+#include <switch.h>
 
 #define APP_DIR "sdmc:/switch"
 
@@ -23,35 +24,84 @@ typedef enum {
     AppEntryType_theme,
 } AppEntryType;
 
+/*
+ * Kept small so the catalog stays cache friendly while sorting and
+ * paging. The strings live in a shared arena, see app_entry_intern.
+ */
 typedef struct {
-    char path[PATH_MAX + 1];
-    char args[APP_ARGS_LEN];
+    const char *path;
+    const char *name;
+    const char *author;
 
-    bool starred;
-    AppEntryType type;
+    u64 sort_key; // Precomputed from starred and the case folded name, see app_entry_cmp
 
-    char name[APP_NAME_LEN];
-    char author[APP_AUTHOR_LEN];
-    char version[APP_VER_LEN];
+    u32 icon_offset; // In the file for homebrew, of the central directory record for themes. 0 if unknown
+    u32 icon_size;
+
+    // Of the file when it was scanned, anything cached about it is only good while these match
+    u64 file_size;
+    s64 file_mtime;
 
     lv_img_dsc_t icon;
     lv_img_dsc_t icon_small;
+
+    char version[APP_VER_LEN];
+
+    AppEntryType type : 8;
+    bool starred : 1;
 } app_entry_t;
 
-void app_entry_init_base(app_entry_t *entry, char *path);
+lv_res_t app_entries_init();
+void app_entries_exit();
+
+const char *app_entry_intern(const char *str, size_t len);
+
+void app_entry_init_base(app_entry_t *entry, const char *path);
 
 lv_res_t app_entry_init_icon(app_entry_t *entry);
 void app_entry_free_icon(app_entry_t *entry);
 
+/*
+ * Reads the icon and decodes it at the small size into a THUMB_SIZE buffer
+ * from the icon store, or shares one already decoded from the same icon.
+ * Doesn't touch LVGL, so it can be run off the UI thread on a copy of the
+ * entry. If *preview is set the decode may be a rough one, which leaves
+ * the JPEG it read in entry->icon so a full decode after it doesn't read
+ * it again. *preview is cleared if the result is final.
+ */
+u8 *app_entry_decode_small_icon(app_entry_t *entry, bool *preview);
+
+// Takes a reference to a THUMB_SIZE buffer from the icon store as the small icon
+void app_entry_set_small_icon(app_entry_t *entry, u8 *data);
+
+// Frees a malloc'd entry along with everything decoded from it
+void app_entry_free(app_entry_t *entry);
+
 lv_res_t app_entry_init_info(app_entry_t *entry);
 
-void app_entry_get_star_path(app_entry_t *entry, char *out_path);
+void app_entry_get_star_path(const char *path, char *out_path);
 lv_res_t app_entry_set_star(app_entry_t *entry, bool star);
 
 lv_res_t app_entry_delete(app_entry_t *entry);
 
-lv_res_t app_entry_add_arg(app_entry_t *entry, char *arg);
-lv_res_t app_entry_load(app_entry_t *entry);
+lv_res_t app_args_add(char *args, const char *arg);
+
+/*
+ * The path is always passed as the first argument, args can
+ * hold more of them built with app_args_add or be NULL.
+ */
+lv_res_t app_entry_load(app_entry_t *entry, const char *args);
+
+// The catalog's order, these live in catalog.c with it
+void app_entry_update_sort_key(app_entry_t *entry);
+int app_entry_cmp(const app_entry_t *a, const app_entry_t *b);
+
+/*
+ * Called for every app found by app_entry_scan, from whichever scan
+ * worker found it and in no particular order, but never concurrently.
+ * The callback takes ownership of the malloc'd entry and should return
+ * false to stop the scan early.
+ */
+typedef bool (*app_entry_scan_cb_t)(app_entry_t *entry, void *arg);
 
-lv_res_t app_entry_ll_ins(lv_ll_t *ll, char *path);
-lv_res_t app_entry_ll_init(lv_ll_t *ll);
\ No newline at end of file
+lv_res_t app_entry_scan(app_entry_scan_cb_t cb, void *arg);
\ No newline at end of file
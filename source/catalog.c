@@ -0,0 +1,203 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <lvgl/lvgl.h>
+
+#include "catalog.h"
+#include "apps.h"
+
+void app_entry_update_sort_key(app_entry_t *entry) {
+    // Unstarred apps get the top bit so starred ones sort first
+    u64 key = entry->starred ? 0 : (1ull << 63);
+
+    // Then the first few case folded bytes of the name, so most comparisons are a single integer one
+    for (int i = 0; i < 7 && entry->name[i] != '\0'; i++)
+        key |= (u64) tolower((u8) entry->name[i]) << (48 - i * 8);
+
+    entry->sort_key = key;
+}
+
+int app_entry_cmp(const app_entry_t *a, const app_entry_t *b) {
+    if (a->sort_key != b->sort_key)
+        return (a->sort_key < b->sort_key) ? -1 : 1;
+
+    return strcasecmp(a->name, b->name);
+}
+
+static int entry_ptr_cmp(const void *a, const void *b) {
+    return app_entry_cmp(*(app_entry_t * const *) a, *(app_entry_t * const *) b);
+}
+
+static lv_res_t catalog_reserve(catalog_t *catalog, int cap) {
+    if (cap <= catalog->cap)
+        return LV_RES_OK;
+
+    int new_cap = (catalog->cap == 0) ? 64 : catalog->cap;
+    while (new_cap < cap)
+        new_cap *= 2;
+
+    app_entry_t **new_entries = realloc(catalog->entries, new_cap * sizeof(app_entry_t *));
+    if (new_entries == NULL)
+        return LV_RES_INV;
+
+    catalog->entries = new_entries;
+    catalog->cap = new_cap;
+
+    return LV_RES_OK;
+}
+
+void catalog_init(catalog_t *catalog) {
+    catalog->entries = NULL;
+    catalog->len = 0;
+    catalog->cap = 0;
+}
+
+void catalog_clear(catalog_t *catalog) {
+    for (int i = 0; i < catalog->len; i++) {
+        app_entry_free(catalog->entries[i]);
+    }
+
+    free(catalog->entries);
+    catalog_init(catalog);
+}
+
+app_entry_t *catalog_get(catalog_t *catalog, int idx) {
+    if (idx < 0 || idx >= catalog->len)
+        return NULL;
+
+    return catalog->entries[idx];
+}
+
+static int lower_bound(catalog_t *catalog, app_entry_t *key) {
+    int lo = 0;
+    int hi = catalog->len;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (app_entry_cmp(catalog->entries[mid], key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+int catalog_find(catalog_t *catalog, app_entry_t *key) {
+    int lo = lower_bound(catalog, key);
+
+    // Different apps can share a name, so check the paths in the equal range
+    for (int i = lo; i < catalog->len && app_entry_cmp(catalog->entries[i], key) == 0; i++) {
+        if (strcmp(catalog->entries[i]->path, key->path) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+lv_res_t catalog_insert(catalog_t *catalog, app_entry_t *entry, int *idx) {
+    if (catalog_reserve(catalog, catalog->len + 1) != LV_RES_OK)
+        return LV_RES_INV;
+
+    int new_idx = lower_bound(catalog, entry);
+
+    memmove(&catalog->entries[new_idx + 1], &catalog->entries[new_idx], (catalog->len - new_idx) * sizeof(app_entry_t *));
+    catalog->entries[new_idx] = entry;
+    catalog->len++;
+
+    if (idx != NULL)
+        *idx = new_idx;
+
+    return LV_RES_OK;
+}
+
+void catalog_remove(catalog_t *catalog, int idx) {
+    if (idx < 0 || idx >= catalog->len)
+        return;
+
+    app_entry_free(catalog->entries[idx]);
+
+    memmove(&catalog->entries[idx], &catalog->entries[idx + 1], (catalog->len - idx - 1) * sizeof(app_entry_t *));
+    catalog->len--;
+}
+
+int catalog_rekey(catalog_t *catalog, int idx) {
+    if (idx < 0 || idx >= catalog->len)
+        return -1;
+
+    app_entry_t *entry = catalog->entries[idx];
+
+    // Take it out and put it back where its new key belongs, only the entries in between move
+    memmove(&catalog->entries[idx], &catalog->entries[idx + 1], (catalog->len - idx - 1) * sizeof(app_entry_t *));
+    catalog->len--;
+
+    int new_idx = lower_bound(catalog, entry);
+
+    memmove(&catalog->entries[new_idx + 1], &catalog->entries[new_idx], (catalog->len - new_idx) * sizeof(app_entry_t *));
+    catalog->entries[new_idx] = entry;
+    catalog->len++;
+
+    return new_idx;
+}
+
+lv_res_t catalog_append(catalog_t *catalog, app_entry_t *entry) {
+    if (catalog_reserve(catalog, catalog->len + 1) != LV_RES_OK)
+        return LV_RES_INV;
+
+    catalog->entries[catalog->len++] = entry;
+
+    return LV_RES_OK;
+}
+
+void catalog_sort(catalog_t *catalog) {
+    qsort(catalog->entries, catalog->len, sizeof(app_entry_t *), entry_ptr_cmp);
+}
+
+lv_res_t catalog_merge(catalog_t *catalog, app_entry_t **entries, int num, int *first_changed) {
+    *first_changed = INT_MAX;
+
+    if (num <= 0)
+        return LV_RES_OK;
+
+    if (catalog_reserve(catalog, catalog->len + num) != LV_RES_OK)
+        return LV_RES_INV;
+
+    qsort(entries, num, sizeof(app_entry_t *), entry_ptr_cmp);
+
+    // Merge from the back so it can be done in place
+    int i = catalog->len - 1;
+    int j = num - 1;
+    int k = catalog->len + num - 1;
+
+    while (j >= 0) {
+        if (i >= 0 && app_entry_cmp(catalog->entries[i], entries[j]) > 0)
+            catalog->entries[k--] = catalog->entries[i--];
+        else
+            catalog->entries[k--] = entries[j--];
+    }
+
+    catalog->len += num;
+    *first_changed = i + 1;
+
+    return LV_RES_OK;
+}
+
+static bool catalog_scan_cb(app_entry_t *entry, void *arg) {
+    if (catalog_append(arg, entry) != LV_RES_OK)
+        free(entry);
+
+    return true;
+}
+
+lv_res_t catalog_scan(catalog_t *catalog) {
+    catalog_clear(catalog);
+
+    // Collect everything first, one sort at the end is far cheaper than sorted inserts
+    lv_res_t res = app_entry_scan(catalog_scan_cb, catalog);
+    catalog_sort(catalog);
+
+    return res;
+}
\ No newline at end of file
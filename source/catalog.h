@@ -0,0 +1,41 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+
+#include "apps.h"
+
+/*
+ * Sorted, index addressable list of malloc'd app entries.
+ * Starred apps come first, then everything is ordered by name.
+ */
+typedef struct {
+    app_entry_t **entries;
+    int len;
+    int cap;
+} catalog_t;
+
+void catalog_init(catalog_t *catalog);
+void catalog_clear(catalog_t *catalog);
+
+app_entry_t *catalog_get(catalog_t *catalog, int idx);
+int catalog_find(catalog_t *catalog, app_entry_t *key);
+
+// Keep the catalog sorted, and take ownership of or free the entries they're given
+lv_res_t catalog_insert(catalog_t *catalog, app_entry_t *entry, int *idx);
+void catalog_remove(catalog_t *catalog, int idx);
+
+// Moves an entry whose sort key changed to its new place and returns its new index
+int catalog_rekey(catalog_t *catalog, int idx);
+
+// Doesn't keep the catalog sorted, catalog_sort has to be called afterwards
+lv_res_t catalog_append(catalog_t *catalog, app_entry_t *entry);
+void catalog_sort(catalog_t *catalog);
+
+/*
+ * Sorts the entries and merges them in, taking ownership of them.
+ * first_changed is set to the lowest index whose entry changed,
+ * or INT_MAX if nothing did.
+ */
+lv_res_t catalog_merge(catalog_t *catalog, app_entry_t **entries, int num, int *first_changed);
+
+lv_res_t catalog_scan(catalog_t *catalog);
\ No newline at end of file
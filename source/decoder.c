@@ -1,145 +1,723 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
 #include <lvgl/lvgl.h>
 #include <turbojpeg.h>
 #include <switch.h>
 
 #include "decoder.h"
+#include "log.h"
+#include "resample.h"
+#include "settings.h"
+
+typedef struct decoded_img {
+    const void *src;
+    u16 w;
+    u16 h;
+
+    u8 *data;
+    size_t size;
+
+    int refs; // Open handles LVGL still draws from
+    bool dropped; // Out of the cache, freed once the last handle is closed
+
+    struct decoded_img *prev;
+    struct decoded_img *next;
+} decoded_img_t;
+
+// The smaller image can be resampled from the bigger one instead of being decoded again
+typedef struct mip_link {
+    const lv_img_dsc_t *src;
+    const lv_img_dsc_t *parent;
+
+    struct mip_link *next;
+} mip_link_t;
+
+// Buffers come in power of two classes from 4KB up, anything bigger goes straight to malloc
+#define POOL_MIN_SHIFT 12
+#define POOL_NUM_CLASSES 10
+#define POOL_MAX_FREE 4 // Per class, the rest is given back
+#define POOL_MAX_DECOMPS 4
+
+// Sits in front of every pooled buffer, 16 bytes keeps the pixels aligned
+typedef struct pool_buf {
+    u32 size_class;
+    struct pool_buf *next;
+} __attribute__((aligned(16))) pool_buf_t;
+
+typedef struct {
+    const char *name;
+
+    // Only descriptors of this color format (up to cf_last if set) that start with the magic bytes are taken
+    lv_img_cf_t cf;
+    lv_img_cf_t cf_last;
+    const u8 *magic;
+    size_t magic_len;
+
+    lv_img_cf_t decoded_cf;
+
+    // Either the whole image is decoded and cached on open, or LVGL gets it a line at a time as it draws
+    lv_res_t (*decode)(const lv_img_dsc_t *img_dsc, u8 *dst, u16 dst_w, u16 dst_h, bool preview);
+    lv_res_t (*read_line)(const lv_img_dsc_t *img_dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, u8 *buf);
+
+    // Or LVGL's own decoder does the work, it's only taken so its lines get counted and timed
+    bool builtin;
+} img_format_t;
+
+typedef struct {
+    u32 magic;
+    u16 w;
+    u16 h;
+    u32 reserved;
+} rle_header_t;
+
+static lv_img_decoder_t *g_dec;
+
+// Shared by the UI thread and the icon loader threads
+static mtx_t g_pool_mtx;
+static pool_buf_t *g_pool_free[POOL_NUM_CLASSES] = {0};
+static u32 g_pool_num_free[POOL_NUM_CLASSES] = {0};
+static tjhandle g_pool_decomps[POOL_MAX_DECOMPS];
+static int g_pool_num_decomps = 0;
+static decoded_img_t *g_free_imgs = NULL;
+static decoder_pool_stats_t g_pool_stats = {0};
+
+// Most recently used first
+static decoded_img_t *g_cache_head = NULL;
+static decoded_img_t *g_cache_tail = NULL;
+static size_t g_cache_budget = 0;
+static decoder_cache_stats_t g_cache_stats = {0};
+static decoder_format_stats_t g_format_stats[DecoderFormat_count] = {0};
+static mip_link_t *g_mip_links = NULL;
+
+static void *pool_alloc(size_t size) {
+    u32 size_class = 0;
+    while (size_class < POOL_NUM_CLASSES && ((size_t) 1 << (POOL_MIN_SHIFT + size_class)) < size + sizeof(pool_buf_t))
+        size_class++;
+
+    mtx_lock(&g_pool_mtx);
+
+    pool_buf_t *buf = NULL;
+    if (size_class < POOL_NUM_CLASSES && g_pool_free[size_class] != NULL) {
+        buf = g_pool_free[size_class];
+        g_pool_free[size_class] = buf->next;
+        g_pool_num_free[size_class]--;
+        g_pool_stats.reuses++;
+    } else {
+        g_pool_stats.allocs++;
+    }
+
+    mtx_unlock(&g_pool_mtx);
 
-static lv_img_decoder_t *g_jpg_dec;
+    if (buf == NULL) {
+        size_t alloc_size = (size_class < POOL_NUM_CLASSES) ? ((size_t) 1 << (POOL_MIN_SHIFT + size_class)) : size + sizeof(pool_buf_t);
+        buf = aligned_alloc(sizeof(pool_buf_t), (alloc_size + sizeof(pool_buf_t) - 1) & ~(sizeof(pool_buf_t) - 1));
+        if (buf == NULL)
+            return NULL;
+
+        buf->size_class = size_class;
+    }
 
-static int pos_from_coord(int x, int y, int w) {
-    return (y * w + x) * sizeof(lv_color_t);
+    return buf + 1;
 }
 
-static void downscale_img(u8 *src, u8 *dst, u32 src_w, u32 src_h, u32 dst_w, u32 dst_h) {
-    if (src_w == dst_w && src_h == dst_h) {
-        memcpy(dst, src, src_w * src_h * sizeof(lv_color_t));
+static void pool_free(void *ptr) {
+    if (ptr == NULL)
         return;
+
+    pool_buf_t *buf = (pool_buf_t *) ptr - 1;
+
+    mtx_lock(&g_pool_mtx);
+
+    if (buf->size_class < POOL_NUM_CLASSES && g_pool_num_free[buf->size_class] < POOL_MAX_FREE) {
+        buf->next = g_pool_free[buf->size_class];
+        g_pool_free[buf->size_class] = buf;
+        g_pool_num_free[buf->size_class]++;
+        buf = NULL;
+    }
+
+    mtx_unlock(&g_pool_mtx);
+
+    free(buf);
+}
+
+static tjhandle get_decomp() {
+    tjhandle decomp = NULL;
+
+    mtx_lock(&g_pool_mtx);
+    if (g_pool_num_decomps > 0)
+        decomp = g_pool_decomps[--g_pool_num_decomps];
+    mtx_unlock(&g_pool_mtx);
+
+    return (decomp != NULL) ? decomp : tjInitDecompress();
+}
+
+static void put_decomp(tjhandle decomp) {
+    mtx_lock(&g_pool_mtx);
+
+    if (g_pool_num_decomps < POOL_MAX_DECOMPS) {
+        g_pool_decomps[g_pool_num_decomps++] = decomp;
+        decomp = NULL;
     }
 
-    float x_scale = (float) src_w / (float) dst_w;
-    float y_scale = (float) src_h / (float) dst_h;
-
-    u8 b[4];
-    u8 g[4];
-    u8 r[4];
-    u8 a[4];
-    float f[4];
-    int w[4];
-
-    for (int x = 0; x < dst_w; x++) {
-        for (int y = 0; y < dst_h; y++) {
-            float src_x = x * x_scale;
-            float src_y = y * y_scale;
-            int pixel_x = src_x;
-            int pixel_y = src_y;
-
-            int pos = pos_from_coord(pixel_x, pixel_y, src_w);
-            b[0] = src[pos];
-            g[0] = src[pos + 1];
-            r[0] = src[pos + 2];
-            a[0] = src[pos + 3];
-
-            pos = pos_from_coord(pixel_x + 1, pixel_y, src_w);
-            b[1] = src[pos];
-            g[1] = src[pos + 1];
-            r[1] = src[pos + 2];
-            a[1] = src[pos + 3];
-
-            pos = pos_from_coord(pixel_x, pixel_y + 1, src_w);
-            b[2] = src[pos];
-            g[2] = src[pos + 1];
-            r[2] = src[pos + 2];
-            a[2] = src[pos + 3];
-
-            pos = pos_from_coord(pixel_x + 1, pixel_y + 1, src_w);
-            b[3] = src[pos];
-            g[3] = src[pos + 1];
-            r[3] = src[pos + 2];
-            a[3] = src[pos + 3];
-
-            f[0] = src_x - pixel_x;
-            f[1] = src_y - pixel_y;
-            f[2] = 1.0f - f[0];
-            f[3] = 1.0f - f[1];
-
-            w[0] = f[2] * f[3] * 256.0;
-            w[1] = f[0] * f[3] * 256.0;
-            w[2] = f[2] * f[1] * 256.0;
-            w[3] = f[0] * f[1] * 256.0;
-
-            pos = pos_from_coord(x, y, dst_w);
-            dst[pos] = (b[0] * w[0] + b[1] * w[1] + b[2] * w[2] + b[3] * w[3]) >> 8;
-            dst[pos + 1] = (g[0] * w[0] + g[1] * w[1] + g[2] * w[2] + g[3] * w[3]) >> 8;
-            dst[pos + 2] = (r[0] * w[0] + r[1] * w[1] + r[2] * w[2] + r[3] * w[3]) >> 8;
-            dst[pos + 3] = (a[0] * w[0] + a[1] * w[1] + a[2] * w[2] + a[3] * w[3]) >> 8;
+    mtx_unlock(&g_pool_mtx);
+
+    if (decomp != NULL)
+        tjDestroy(decomp);
+}
+
+static void pool_clear() {
+    mtx_lock(&g_pool_mtx);
+
+    for (int i = 0; i < POOL_NUM_CLASSES; i++) {
+        while (g_pool_free[i] != NULL) {
+            pool_buf_t *next = g_pool_free[i]->next;
+            free(g_pool_free[i]);
+            g_pool_free[i] = next;
         }
+
+        g_pool_num_free[i] = 0;
+    }
+
+    while (g_pool_num_decomps > 0)
+        tjDestroy(g_pool_decomps[--g_pool_num_decomps]);
+
+    mtx_unlock(&g_pool_mtx);
+
+    // Only the UI thread touches the cache nodes
+    while (g_free_imgs != NULL) {
+        decoded_img_t *next = g_free_imgs->next;
+        free(g_free_imgs);
+        g_free_imgs = next;
     }
 }
 
-static lv_res_t jpg_dec_info(lv_img_decoder_t *dec, const void *src, lv_img_header_t *header) {
+static void cache_unlink(decoded_img_t *img) {
+    if (img->prev != NULL)
+        img->prev->next = img->next;
+    else
+        g_cache_head = img->next;
+
+    if (img->next != NULL)
+        img->next->prev = img->prev;
+    else
+        g_cache_tail = img->prev;
+
+    img->prev = NULL;
+    img->next = NULL;
+
+    g_cache_stats.bytes_used -= img->size;
+}
+
+static void cache_push_front(decoded_img_t *img) {
+    img->prev = NULL;
+    img->next = g_cache_head;
+
+    if (g_cache_head != NULL)
+        g_cache_head->prev = img;
+    else
+        g_cache_tail = img;
+
+    g_cache_head = img;
+
+    g_cache_stats.bytes_used += img->size;
+}
+
+static void cache_release(decoded_img_t *img) {
+    if (img->refs > 0)
+        return;
+
+    pool_free(img->data);
+
+    img->next = g_free_imgs;
+    g_free_imgs = img;
+}
+
+static void cache_drop(decoded_img_t *img) {
+    cache_unlink(img);
+    img->dropped = true;
+
+    cache_release(img);
+}
+
+static decoded_img_t *cache_find(const void *src, u16 w, u16 h) {
+    for (decoded_img_t *img = g_cache_head; img != NULL; img = img->next) {
+        if (img->src == src && img->w == w && img->h == h)
+            return img;
+    }
+
+    return NULL;
+}
+
+static void cache_trim() {
+    decoded_img_t *img = g_cache_tail;
+
+    // Images that are still open can't go, LVGL would be left drawing from freed memory
+    while (g_cache_stats.bytes_used > g_cache_budget && img != NULL) {
+        decoded_img_t *prev = img->prev;
+
+        if (img->refs == 0) {
+            cache_drop(img);
+            g_cache_stats.evictions++;
+        }
+
+        img = prev;
+    }
+}
+
+/*
+ * Decodes straight to the smallest DCT scaled size that still covers the
+ * target, then resamples the rest of the way. When the scaled size is the
+ * target the pixels go right into dst. A preview takes the smallest size
+ * there is, which only needs the DC coefficients, and scales that up.
+ */
+static lv_res_t decode_jpg(const lv_img_dsc_t *img_dsc, u8 *dst, u16 dst_w, u16 dst_h, bool preview) {
+    tjhandle decomp = get_decomp();
+    if (decomp == NULL)
+        return LV_RES_INV;
+
+    int w, h, samp, color_space;
+
+    if (tjDecompressHeader3(decomp, img_dsc->data, img_dsc->data_size, &w, &h, &samp, &color_space) || dst_w > w || dst_h > h) {
+        put_decomp(decomp);
+        return LV_RES_INV;
+    }
+
+    int num_factors;
+    tjscalingfactor *factors = tjGetScalingFactors(&num_factors);
+
+    int scaled_w = w;
+    int scaled_h = h;
+
+    for (int i = 0; factors != NULL && i < num_factors; i++) {
+        int factor_w = TJSCALED(w, factors[i]);
+        int factor_h = TJSCALED(h, factors[i]);
+
+        if ((preview || (factor_w >= dst_w && factor_h >= dst_h)) && factor_w * factor_h < scaled_w * scaled_h) {
+            scaled_w = factor_w;
+            scaled_h = factor_h;
+        }
+    }
+
+    bool direct = scaled_w == dst_w && scaled_h == dst_h;
+
+    u8 *scaled_data = dst;
+    if (!direct && (scaled_data = pool_alloc(scaled_w * scaled_h * sizeof(lv_color_t))) == NULL) {
+        put_decomp(decomp);
+        return LV_RES_INV;
+    }
+
+    int err = tjDecompress2(decomp, img_dsc->data, img_dsc->data_size, scaled_data, scaled_w, 0, scaled_h, TJPF_BGRA, preview ? (TJFLAG_FASTDCT | TJFLAG_FASTUPSAMPLE) : TJFLAG_ACCURATEDCT);
+
+    put_decomp(decomp);
+
+    if (direct)
+        return err ? LV_RES_INV : LV_RES_OK;
+
+    void *scratch = NULL;
+    if (!err && (scratch = pool_alloc(resample_scratch_size(scaled_w, scaled_h, dst_w, dst_h))) != NULL)
+        resample_bgra(scaled_data, scaled_w, scaled_h, dst, dst_w, dst_h, scratch);
+
+    pool_free(scratch);
+    pool_free(scaled_data);
+
+    return (scratch != NULL) ? LV_RES_OK : LV_RES_INV;
+}
+
+/*
+ * Each row is a run of packets. A control byte with the top bit set is
+ * followed by one pixel repeated (c & 0x7f) + 1 times, otherwise c + 1
+ * literal pixels follow.
+ */
+static lv_res_t rle_read_line(const lv_img_dsc_t *img_dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, u8 *buf) {
+    const rle_header_t *header = (const rle_header_t *) img_dsc->data;
+    if (y < 0 || y >= header->h || x < 0 || x + len > header->w)
+        return LV_RES_INV;
+
+    const u32 *row_offsets = (const u32 *) (header + 1);
+    const u8 *p = img_dsc->data + row_offsets[y];
+
+    // Packets that end before x are only skipped over
+    while (len > 0) {
+        u8 ctrl = *p++;
+        lv_coord_t count = (ctrl & 0x7f) + 1;
+        bool repeat = ctrl & 0x80;
+
+        if (x >= count) {
+            x -= count;
+            p += repeat ? sizeof(lv_color_t) : count * sizeof(lv_color_t);
+            continue;
+        }
+
+        lv_coord_t num = LV_MATH_MIN(count - x, len);
+
+        if (repeat) {
+            for (lv_coord_t i = 0; i < num; i++)
+                memcpy(buf + i * sizeof(lv_color_t), p, sizeof(lv_color_t));
+
+            p += sizeof(lv_color_t);
+        } else {
+            memcpy(buf, p + x * sizeof(lv_color_t), num * sizeof(lv_color_t));
+            p += count * sizeof(lv_color_t);
+        }
+
+        buf += num * sizeof(lv_color_t);
+        len -= num;
+        x = 0;
+    }
+
+    return LV_RES_OK;
+}
+
+// Indexed by DecoderFormat, anything that isn't one of these is left to LVGL's own decoders
+static const img_format_t g_formats[DecoderFormat_builtin] = {
+    [DecoderFormat_jpeg] = {
+        .name = "jpeg",
+        .cf = LV_IMG_CF_RAW,
+        .magic = (const u8[]) {0xff, 0xd8, 0xff},
+        .magic_len = 3,
+        // No alpha in a JPEG, so LVGL can copy the pixels instead of blending them
+        .decoded_cf = LV_IMG_CF_TRUE_COLOR,
+        .decode = decode_jpg,
+    },
+    [DecoderFormat_rle] = {
+        .name = "rle",
+        .cf = LV_IMG_CF_RAW_ALPHA,
+        .magic = (const u8[]) {'H', 'R', 'L', 'E'},
+        .magic_len = 4,
+        .decoded_cf = LV_IMG_CF_TRUE_COLOR_ALPHA,
+        .read_line = rle_read_line,
+    },
+    [DecoderFormat_indexed] = {
+        .name = "indexed",
+        .cf = LV_IMG_CF_INDEXED_1BIT,
+        .cf_last = LV_IMG_CF_INDEXED_8BIT,
+        .builtin = true,
+    },
+};
+
+static DecoderFormat find_format(const void *src) {
     // Let's not deal with it if it's not an image descriptor
     if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE)
+        return DecoderFormat_builtin;
+
+    const lv_img_dsc_t *dsc = src;
+
+    for (int i = 0; i < DecoderFormat_builtin; i++) {
+        const img_format_t *format = &g_formats[i];
+
+        bool cf_match = dsc->header.cf == format->cf || (dsc->header.cf > format->cf && dsc->header.cf <= format->cf_last);
+
+        if (cf_match && dsc->data_size >= format->magic_len && (format->magic_len == 0 || memcmp(dsc->data, format->magic, format->magic_len) == 0))
+            return i;
+    }
+
+    return DecoderFormat_builtin;
+}
+
+static lv_res_t img_dec_info(lv_img_decoder_t *dec, const void *src, lv_img_header_t *header) {
+    DecoderFormat format = find_format(src);
+
+    g_format_stats[format].probes++;
+
+    // Already decoded images, like the theme's and the icon thumbnails, never get near turbojpeg
+    if (format == DecoderFormat_builtin)
         return LV_RES_INV;
 
+    if (g_formats[format].builtin)
+        return lv_img_decoder_built_in_info(dec, src, header);
+
     const lv_img_dsc_t *dsc = src;
 
     header->always_zero = 0;
     header->w = dsc->header.w;
     header->h = dsc->header.h;
-    header->cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    header->cf = g_formats[format].decoded_cf;
 
     return LV_RES_OK;
 }
 
-static lv_res_t jpg_dec_open(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc) {
-    // Let's not deal with it if it's not an image descriptor
-    if (dsc->src_type != LV_IMG_SRC_VARIABLE)
+static lv_res_t resample_from(decoded_img_t *from, u8 *dst, u16 dst_w, u16 dst_h) {
+    void *scratch = pool_alloc(resample_scratch_size(from->w, from->h, dst_w, dst_h));
+    if (scratch == NULL)
         return LV_RES_INV;
 
-    const lv_img_dsc_t *img_dsc = dsc->src;
+    resample_bgra(from->data, from->w, from->h, dst, dst_w, dst_h, scratch);
+    pool_free(scratch);
 
-    tjhandle decomp = tjInitDecompress();
-    if (decomp == NULL)
-        return LV_RES_INV;
+    return LV_RES_OK;
+}
 
-    int w, h, samp, color_space;
+// Anything that doesn't fit the budget on its own just isn't kept, the caller still owns the data then
+static decoded_img_t *cache_insert(const void *src, u16 w, u16 h, u8 *data, int refs) {
+    size_t size = w * h * sizeof(lv_color_t);
 
-    if (tjDecompressHeader3(decomp, img_dsc->data, img_dsc->data_size, &w, &h, &samp, &color_space)) {
-        tjDestroy(decomp);
-        return LV_RES_INV;
+    if (size > g_cache_budget)
+        return NULL;
+
+    decoded_img_t *img = g_free_imgs;
+    if (img != NULL)
+        g_free_imgs = img->next;
+    else if ((img = malloc(sizeof(decoded_img_t))) == NULL)
+        return NULL;
+
+    img->src = src;
+    img->w = w;
+    img->h = h;
+    img->data = data;
+    img->size = size;
+    img->refs = refs;
+    img->dropped = false;
+
+    cache_push_front(img);
+    cache_trim();
+
+    return img;
+}
+
+static decoded_img_t *find_mip_parent(const void *src) {
+    for (mip_link_t *link = g_mip_links; link != NULL; link = link->next) {
+        if (link->src == src)
+            return cache_find(link->parent, link->parent->header.w, link->parent->header.h);
     }
 
-    if (img_dsc->header.w > w || img_dsc->header.h > h) {
-        tjDestroy(decomp);
+    return NULL;
+}
+
+// Makes the smaller versions of an image from the bigger one while it's at hand
+static void fill_mip_children(decoded_img_t *img) {
+    for (mip_link_t *link = g_mip_links; link != NULL; link = link->next) {
+        if (link->parent != img->src || cache_find(link->src, link->src->header.w, link->src->header.h) != NULL)
+            continue;
+
+        u16 w = link->src->header.w;
+        u16 h = link->src->header.h;
+
+        u8 *data = pool_alloc(w * h * sizeof(lv_color_t));
+        if (data == NULL)
+            continue;
+
+        if (resample_from(img, data, w, h) != LV_RES_OK || cache_insert(link->src, w, h, data, 0) == NULL)
+            pool_free(data);
+    }
+}
+
+static lv_res_t img_dec_open(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc) {
+    DecoderFormat format = find_format(dsc->src);
+    if (format == DecoderFormat_builtin)
         return LV_RES_INV;
+
+    g_format_stats[format].opens++;
+
+    if (g_formats[format].builtin)
+        return lv_img_decoder_built_in_open(dec, dsc);
+
+    // Nothing to keep around, it's all done as the lines are drawn
+    if (g_formats[format].read_line != NULL) {
+        dsc->img_data = NULL;
+        dsc->user_data = NULL;
+        return LV_RES_OK;
     }
 
-    u8 *img_data = tjAlloc(w * h * sizeof(lv_color_t));
+    const lv_img_dsc_t *img_dsc = dsc->src;
+    u16 w = img_dsc->header.w;
+    u16 h = img_dsc->header.h;
 
-    if (tjDecompress2(decomp, img_dsc->data, img_dsc->data_size, img_data, w, 0, h, TJPF_BGRA, TJFLAG_ACCURATEDCT)) {
-        tjFree(img_data);
-        tjDestroy(decomp);
+    decoded_img_t *img = cache_find(dsc->src, w, h);
+    if (img != NULL) {
+        g_cache_stats.hits++;
+
+        cache_unlink(img);
+        cache_push_front(img);
+
+        img->refs++;
+
+        dsc->img_data = img->data;
+        dsc->user_data = img;
+
+        return LV_RES_OK;
+    }
+
+    g_cache_stats.misses++;
+
+    u64 start_tick = armGetSystemTick();
+
+    u8 *data = pool_alloc(w * h * sizeof(lv_color_t));
+    if (data == NULL)
+        return LV_RES_INV;
+
+    lv_res_t res;
+    decoded_img_t *parent = find_mip_parent(dsc->src);
+    bool from_mip = parent != NULL && parent->w >= w && parent->h >= h;
+
+    if (from_mip)
+        res = resample_from(parent, data, w, h);
+    else
+        res = g_formats[format].decode(img_dsc, data, w, h, false);
+
+    if (res != LV_RES_OK) {
+        pool_free(data);
         return LV_RES_INV;
     }
 
-    u8 *resized_data = tjAlloc(img_dsc->header.w * img_dsc->header.h * sizeof(lv_color_t));
-    downscale_img(img_data, resized_data, w, h, img_dsc->header.w, img_dsc->header.h);
+    u64 ns = armTicksToNs(armGetSystemTick() - start_tick);
+
+    if (from_mip) {
+        g_cache_stats.mip_resamples++;
+        g_cache_stats.mip_resample_ns += ns;
+    } else {
+        g_cache_stats.decodes++;
+        g_cache_stats.decode_ns += ns;
+    }
+
+    dsc->img_data = data;
+    dsc->user_data = cache_insert(dsc->src, w, h, data, 1);
 
-    dsc->img_data = resized_data;
+    if (dsc->user_data != NULL)
+        fill_mip_children(dsc->user_data);
 
-    tjFree(img_data);
-    tjDestroy(decomp);
     return LV_RES_OK;
 }
 
-static void jpg_dec_close(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc) {
-    tjFree((unsigned char *) dsc->img_data);
+static lv_res_t img_dec_read_line(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, u8 *buf) {
+    DecoderFormat format = find_format(dsc->src);
+    if (format == DecoderFormat_builtin || (g_formats[format].read_line == NULL && !g_formats[format].builtin))
+        return LV_RES_INV;
+
+    u64 start_tick = armGetSystemTick();
+
+    lv_res_t res;
+    if (g_formats[format].builtin)
+        res = lv_img_decoder_built_in_read_line(dec, dsc, x, y, len, buf);
+    else
+        res = g_formats[format].read_line(dsc->src, x, y, len, buf);
+
+    g_format_stats[format].lines++;
+    g_format_stats[format].line_ns += armTicksToNs(armGetSystemTick() - start_tick);
+
+    return res;
 }
 
+static void img_dec_close(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc) {
+    DecoderFormat format = find_format(dsc->src);
+
+    if (format != DecoderFormat_builtin && g_formats[format].builtin) {
+        lv_img_decoder_built_in_close(dec, dsc);
+        return;
+    }
+
+    decoded_img_t *img = dsc->user_data;
+
+    if (img == NULL) {
+        pool_free((u8 *) dsc->img_data);
+        return;
+    }
+
+    img->refs--;
+
+    if (img->dropped)
+        cache_release(img);
+}
 
 void decoderInitialize() {
-    g_jpg_dec = lv_img_decoder_create();
-    lv_img_decoder_set_info_cb(g_jpg_dec, jpg_dec_info);
-    lv_img_decoder_set_open_cb(g_jpg_dec, jpg_dec_open);
-    lv_img_decoder_set_close_cb(g_jpg_dec, jpg_dec_close);
+    g_dec = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(g_dec, img_dec_info);
+    lv_img_decoder_set_open_cb(g_dec, img_dec_open);
+    lv_img_decoder_set_read_line_cb(g_dec, img_dec_read_line);
+    lv_img_decoder_set_close_cb(g_dec, img_dec_close);
+
+    g_cache_budget = (size_t) curr_settings()->icon_cache_kb * 1024;
+
+    mtx_init(&g_pool_mtx, mtx_plain);
+}
+
+void decoderExit() {
+    decoderCacheClear();
+
+    while (g_mip_links != NULL) {
+        mip_link_t *next = g_mip_links->next;
+        free(g_mip_links);
+        g_mip_links = next;
+    }
+
+    pool_clear();
+    mtx_destroy(&g_pool_mtx);
+
+    logPrintf("decoder cache: %u hits, %u misses, %u evictions\n", g_cache_stats.hits, g_cache_stats.misses, g_cache_stats.evictions);
+    logPrintf("decoder cache: %u decodes in %lluus, %u mip resamples in %lluus\n", g_cache_stats.decodes, g_cache_stats.decode_ns / 1000, g_cache_stats.mip_resamples, g_cache_stats.mip_resample_ns / 1000);
+    logPrintf("decoder pool: %u allocs, %u reuses\n", g_pool_stats.allocs, g_pool_stats.reuses);
+    logPrintf("decoder formats: jpeg %u probes, %u opens, builtin %u probes\n", g_format_stats[DecoderFormat_jpeg].probes, g_format_stats[DecoderFormat_jpeg].opens, g_format_stats[DecoderFormat_builtin].probes);
+    logPrintf("decoder formats: rle %u opens, %u lines in %lluus\n", g_format_stats[DecoderFormat_rle].opens, g_format_stats[DecoderFormat_rle].lines, g_format_stats[DecoderFormat_rle].line_ns / 1000);
+    logPrintf("decoder formats: indexed %u opens, %u lines in %lluus\n", g_format_stats[DecoderFormat_indexed].opens, g_format_stats[DecoderFormat_indexed].lines, g_format_stats[DecoderFormat_indexed].line_ns / 1000);
+}
+
+void decoderCacheDrop(const void *src) {
+    // Have LVGL let go of its own handle first
+    lv_img_cache_invalidate_src(src);
+
+    mip_link_t **link = &g_mip_links;
+    while (*link != NULL) {
+        if ((*link)->src == src || (*link)->parent == src) {
+            mip_link_t *next = (*link)->next;
+            free(*link);
+            *link = next;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+
+    decoded_img_t *img = g_cache_head;
+    while (img != NULL) {
+        decoded_img_t *next = img->next;
+
+        if (img->src == src)
+            cache_drop(img);
+
+        img = next;
+    }
+}
+
+void decoderCacheClear() {
+    lv_img_cache_invalidate_src(NULL);
+
+    while (g_cache_head != NULL)
+        cache_drop(g_cache_head);
+}
+
+lv_res_t decoderDecodeTo(const lv_img_dsc_t *src, u8 *dst, u16 w, u16 h) {
+    return decode_jpg(src, dst, w, h, false);
+}
+
+lv_res_t decoderDecodePreviewTo(const lv_img_dsc_t *src, u8 *dst, u16 w, u16 h) {
+    return decode_jpg(src, dst, w, h, true);
+}
+
+void decoderCacheLinkMip(const lv_img_dsc_t *src, const lv_img_dsc_t *parent) {
+    for (mip_link_t *link = g_mip_links; link != NULL; link = link->next) {
+        if (link->src == src && link->parent == parent)
+            return;
+    }
+
+    mip_link_t *link = malloc(sizeof(mip_link_t));
+    if (link == NULL)
+        return;
+
+    link->src = src;
+    link->parent = parent;
+    link->next = g_mip_links;
+    g_mip_links = link;
+}
+
+void decoderGetCacheStats(decoder_cache_stats_t *stats) {
+    *stats = g_cache_stats;
+}
+
+void decoderGetPoolStats(decoder_pool_stats_t *stats) {
+    mtx_lock(&g_pool_mtx);
+    *stats = g_pool_stats;
+    mtx_unlock(&g_pool_mtx);
+}
+
+void decoderGetFormatStats(decoder_format_stats_t *stats) {
+    memcpy(stats, g_format_stats, sizeof(g_format_stats));
 }
\ No newline at end of file
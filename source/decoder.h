@@ -1,5 +1,71 @@
 #pragma once
 
 #include <lvgl/lvgl.h>
+#include <switch.h>
 
-void decoderInitialize();
\ No newline at end of file
+typedef struct {
+    u32 hits;
+    u32 misses;
+    u32 evictions;
+    size_t bytes_used;
+
+    // What the misses cost, a full decode or a resample of a cached bigger size
+    u32 decodes;
+    u64 decode_ns;
+    u32 mip_resamples;
+    u64 mip_resample_ns;
+} decoder_cache_stats_t;
+
+typedef enum {
+    DecoderFormat_jpeg,
+    DecoderFormat_rle, // Run length encoded BGRA from tools/gen_theme.py, drawn a line at a time
+    DecoderFormat_indexed, // Palette images, LVGL decodes them but they're counted here
+    DecoderFormat_builtin, // Anything LVGL decodes itself
+    DecoderFormat_count,
+} DecoderFormat;
+
+typedef struct {
+    u32 probes; // Times LVGL asked which decoder an image goes to
+    u32 opens; // Decodes or cache hits, LVGL's own decoders aren't counted
+    u32 lines; // Decoded while drawing, for formats that aren't cached whole
+    u64 line_ns;
+} decoder_format_stats_t;
+
+typedef struct {
+    u32 allocs; // Buffers that had to come from the heap
+    u32 reuses;
+} decoder_pool_stats_t;
+
+void decoderInitialize();
+void decoderExit();
+
+/*
+ * Decoded images are kept by descriptor and size under the icon_cache_kb
+ * budget, least recently used first out. Whatever owns a descriptor has
+ * to drop it before the descriptor goes away or starts pointing at a
+ * different image.
+ */
+void decoderCacheDrop(const void *src);
+void decoderCacheClear();
+
+/*
+ * Marks src as a smaller version of parent, so it's resampled from the
+ * decoded parent when that's cached, and made right away whenever the
+ * parent gets decoded.
+ */
+void decoderCacheLinkMip(const lv_img_dsc_t *src, const lv_img_dsc_t *parent);
+
+/*
+ * Decodes a JPEG descriptor at w x h into dst. It stays clear of the cache,
+ * so any thread may use it. Decompressors and scratch buffers are pooled.
+ */
+lv_res_t decoderDecodeTo(const lv_img_dsc_t *src, u8 *dst, u16 w, u16 h);
+
+// Same as decoderDecodeTo, but only a blurry 1/8 scale decode made bigger. It costs a fraction of the full one
+lv_res_t decoderDecodePreviewTo(const lv_img_dsc_t *src, u8 *dst, u16 w, u16 h);
+
+void decoderGetCacheStats(decoder_cache_stats_t *stats);
+void decoderGetPoolStats(decoder_pool_stats_t *stats);
+
+// Fills DecoderFormat_count entries
+void decoderGetFormatStats(decoder_format_stats_t *stats);
\ No newline at end of file
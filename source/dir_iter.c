@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <lvgl/lvgl.h>
+
+#include "dir_iter.h"
+
+#ifdef __SWITCH__
+
+lv_res_t dir_iter_open(dir_iter_t *it, const char *path) {
+    // Paths come as device:/path, the device's file system wants just the path
+    const char *colon = strchr(path, ':');
+    if (colon == NULL || colon - path >= 32)
+        return LV_RES_INV;
+
+    char device[32];
+    memcpy(device, path, colon - path);
+    device[colon - path] = '\0';
+
+    char fs_path[FS_MAX_PATH];
+    snprintf(fs_path, sizeof(fs_path), "%s", (colon[1] == '\0') ? "/" : colon + 1);
+
+    FsFileSystem *fs = fsdevGetDeviceFileSystem(device);
+    if (fs == NULL)
+        return LV_RES_INV;
+
+    it->buf = malloc(DIR_ITER_BATCH * sizeof(FsDirectoryEntry));
+    if (it->buf == NULL)
+        return LV_RES_INV;
+
+    if (R_FAILED(fsFsOpenDirectory(fs, fs_path, FsDirOpenMode_ReadDirs | FsDirOpenMode_ReadFiles, &it->dir))) {
+        free(it->buf);
+        return LV_RES_INV;
+    }
+
+    it->num = 0;
+    it->pos = 0;
+
+    return LV_RES_OK;
+}
+
+void dir_iter_close(dir_iter_t *it) {
+    fsDirClose(&it->dir);
+    free(it->buf);
+}
+
+dir_iter_entry_t *dir_iter_next(dir_iter_t *it) {
+    if (it->pos >= it->num) {
+        it->pos = 0;
+
+        if (R_FAILED(fsDirRead(&it->dir, &it->num, DIR_ITER_BATCH, it->buf)) || it->num <= 0) {
+            it->num = 0;
+            return NULL;
+        }
+    }
+
+    FsDirectoryEntry *fs_entry = &it->buf[it->pos++];
+
+    it->curr.name = fs_entry->name;
+    it->curr.is_dir = fs_entry->type == FsDirEntryType_Dir;
+    it->curr.size = fs_entry->file_size;
+
+    return &it->curr;
+}
+
+#else
+
+lv_res_t dir_iter_open(dir_iter_t *it, const char *path) {
+    it->dp = opendir(path);
+    if (it->dp == NULL)
+        return LV_RES_INV;
+
+    snprintf(it->path, sizeof(it->path), "%s", path);
+
+    return LV_RES_OK;
+}
+
+void dir_iter_close(dir_iter_t *it) {
+    closedir(it->dp);
+}
+
+dir_iter_entry_t *dir_iter_next(dir_iter_t *it) {
+    struct dirent *ep;
+
+    do {
+        ep = readdir(it->dp);
+        if (ep == NULL)
+            return NULL;
+    } while (strcmp(ep->d_name, ".") == 0 || strcmp(ep->d_name, "..") == 0);
+
+    it->curr.name = ep->d_name;
+    it->curr.is_dir = ep->d_type == DT_DIR;
+    it->curr.size = -1;
+
+    // readdir has no sizes, only a file system without d_type gets the stat
+    if (ep->d_type == DT_UNKNOWN) {
+        char path[PATH_MAX + 1];
+        snprintf(path, sizeof(path), "%s/%s", it->path, ep->d_name);
+
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            it->curr.is_dir = S_ISDIR(st.st_mode);
+            it->curr.size = it->curr.is_dir ? 0 : st.st_size;
+        }
+    }
+
+    return &it->curr;
+}
+
+#endif
\ No newline at end of file
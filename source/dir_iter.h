@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+#include <lvgl/lvgl.h>
+
+#ifdef __SWITCH__
+
+#include <switch.h>
+
+#else
+
+#include <dirent.h>
+
+#endif
+
+#define DIR_ITER_BATCH 32
+
+typedef struct {
+    const char *name;
+    bool is_dir;
+    int64_t size; // -1 where the backend can't tell without a stat
+} dir_iter_entry_t;
+
+/*
+ * Lists a directory a batch at a time, with the type and size of every
+ * entry, so nothing has to be stat'ed just to tell files and directories
+ * apart. On the Switch this reads straight from the device's file system,
+ * elsewhere readdir stands in for it.
+ */
+typedef struct {
+    #ifdef __SWITCH__
+
+    FsDir dir;
+    FsDirectoryEntry *buf;
+    s64 num;
+    s64 pos;
+
+    #else
+
+    DIR *dp;
+    char path[PATH_MAX + 1];
+
+    #endif
+
+    dir_iter_entry_t curr;
+} dir_iter_t;
+
+lv_res_t dir_iter_open(dir_iter_t *it, const char *path);
+void dir_iter_close(dir_iter_t *it);
+
+// Returns NULL once the directory is done, the entry is only good until the next call
+dir_iter_entry_t *dir_iter_next(dir_iter_t *it);
\ No newline at end of file
@@ -25,6 +25,7 @@ static lv_obj_t * g_pointer_fake_canvas;
 static float g_pointer_screen_magic = 0.7071f; // This is a repeating number that describes the top right of a square inside a unit circle whose sides are parallel to the x-y axis'
 static lv_indev_t *g_gyro_indev;
 static bool g_clear_pointer_canvas = true;
+static const lv_img_dsc_t *g_cursor_dsc; // Loaded while the pointer is shown, its data stays NULL if that failed
 
 static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p) {
     u32 stride;
@@ -79,6 +80,8 @@ static bool keypad_cb(lv_indev_drv_t *drv, lv_indev_data_t *data) {
         data->key = LV_KEY_DOWN;
     else if (pressed & KEY_UP)
         data->key = LV_KEY_UP;
+    else if (pressed & KEY_Y)
+        data->key = KEYPAD_KEY_SEARCH;
     else
         data->state = LV_INDEV_STATE_REL;
 
@@ -147,7 +150,8 @@ static bool gyro_cb(lv_indev_drv_t *drv, lv_indev_data_t *data) {
 
     // Clear canvas and draw rotated pointer according to finalvector.z
     memset(g_pointer_buf, 0, sizeof(g_pointer_buf));
-    lv_canvas_rotate(g_pointer_canvas, &curr_theme()->cursor_dsc,  z_rad * 180 / M_PI, 0, 0, 96 / 2, 96 / 2);
+    if (g_cursor_dsc != NULL && g_cursor_dsc->data != NULL)
+        lv_canvas_rotate(g_pointer_canvas, g_cursor_dsc,  z_rad * 180 / M_PI, 0, 0, 96 / 2, 96 / 2);
     lv_obj_align(g_pointer_canvas, g_pointer_fake_canvas, LV_ALIGN_IN_TOP_LEFT, -48, -48);
     
     return false;
@@ -161,6 +165,8 @@ static void handheld_changed_task(lv_task_t * t) {
         if (g_clear_pointer_canvas) {
             g_clear_pointer_canvas = false;
             lv_obj_set_opa_scale(g_pointer_canvas, LV_OPA_TRANSP);
+            g_cursor_dsc = NULL;
+            theme_unuse(ThemeLazy_cursor);
         }
     } else {
         g_gyro_indev->proc.disabled = false;
@@ -169,6 +175,7 @@ static void handheld_changed_task(lv_task_t * t) {
         if (!g_clear_pointer_canvas) {
             g_clear_pointer_canvas = true;
             lv_obj_set_opa_scale(g_pointer_canvas, LV_OPA_100);
+            g_cursor_dsc = &theme_use(ThemeLazy_cursor)->cursor_dsc;
         }
     }
 }
@@ -225,6 +232,8 @@ void driversInitialize() {
 
             g_clear_pointer_canvas = false;
             lv_obj_set_opa_scale(g_pointer_canvas, LV_OPA_TRANSP);
+        } else {
+            g_cursor_dsc = &theme_use(ThemeLazy_cursor)->cursor_dsc;
         }
 
         lv_task_t * handheld_check = lv_task_create(handheld_changed_task, 500, LV_TASK_PRIO_MID, NULL);
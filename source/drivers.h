@@ -4,6 +4,8 @@
 
 #define CURSOR_SENSITIVITY 2
 
+#define KEYPAD_KEY_SEARCH LV_KEY_HOME // Sent for Y
+
 void driversInitialize();
 void driversExit();
 
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <threads.h>
+#include <lvgl/lvgl.h>
+
+#include "favorites.h"
+#include "apps.h"
+#include "log.h"
+#include "util.h"
+
+#define FAVORITES_FLUSH_PERIOD 2000
+
+// Marks a removed slot so lookups keep probing past it
+static char g_tombstone;
+
+static mtx_t g_mtx;
+static char **g_slots = NULL;
+static size_t g_slots_cap = 0;
+static size_t g_slots_used = 0; // Includes tombstones
+static bool g_dirty = false;
+static bool g_migrating = false;
+static lv_task_t *g_flush_task = NULL;
+
+static char **find_slot(const char *path) {
+    return hash_find_slot(g_slots, sizeof(char *), g_slots_cap, path, strlen(path), &g_tombstone);
+}
+
+static bool is_set(char *slot) {
+    return slot != NULL && slot != &g_tombstone;
+}
+
+static void set_locked(const char *path, size_t len, bool fav) {
+    if (fav) {
+        char **slots = hash_grow(g_slots, sizeof(char *), &g_slots_cap, &g_slots_used, 64, &g_tombstone);
+        if (slots == NULL)
+            return;
+
+        g_slots = slots;
+    }
+
+    if (g_slots_cap == 0)
+        return;
+
+    char *tmp = strndup(path, len);
+    if (tmp == NULL)
+        return;
+
+    char **slot = find_slot(tmp);
+
+    if (fav && !is_set(*slot)) {
+        if (*slot == NULL)
+            g_slots_used++;
+
+        *slot = tmp;
+        g_dirty = true;
+
+        return;
+    }
+
+    if (!fav && is_set(*slot)) {
+        free(*slot);
+        *slot = &g_tombstone;
+        g_dirty = true;
+    }
+
+    free(tmp);
+}
+
+static void flush_task(lv_task_t *task) {
+    favorites_flush();
+}
+
+static lv_res_t load() {
+    FILE *fp = fopen(FAVORITES_PATH, "rb");
+    if (fp == NULL)
+        return LV_RES_INV;
+
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char *buf = malloc(file_size + 1);
+    if (buf == NULL) {
+        fclose(fp);
+        return LV_RES_OK; // The file is there, so there's nothing to migrate either way
+    }
+
+    if (file_size > 0 && fread(buf, file_size, 1, fp) != 1)
+        file_size = 0;
+
+    fclose(fp);
+
+    buf[file_size] = '\n';
+
+    // One path per line
+    char *line = buf;
+    char *end = buf + file_size;
+
+    while (line < end) {
+        char *nl = memchr(line, '\n', end + 1 - line);
+        size_t len = nl - line;
+
+        if (len > 0 && line[len - 1] == '\r')
+            len--;
+
+        if (len > 0)
+            set_locked(line, len, true);
+
+        line = nl + 1;
+    }
+
+    free(buf);
+
+    return LV_RES_OK;
+}
+
+lv_res_t favorites_init() {
+    mtx_init(&g_mtx, mtx_plain);
+
+    if (load() != LV_RES_OK)
+        g_migrating = true;
+
+    g_dirty = false;
+
+    g_flush_task = lv_task_create(flush_task, FAVORITES_FLUSH_PERIOD, LV_TASK_PRIO_LOWEST, NULL);
+
+    return LV_RES_OK;
+}
+
+void favorites_exit() {
+    if (g_flush_task != NULL) {
+        lv_task_del(g_flush_task);
+        g_flush_task = NULL;
+    }
+
+    favorites_flush();
+
+    for (size_t i = 0; i < g_slots_cap; i++) {
+        if (is_set(g_slots[i]))
+            free(g_slots[i]);
+    }
+
+    free(g_slots);
+
+    g_slots = NULL;
+    g_slots_cap = 0;
+    g_slots_used = 0;
+
+    mtx_destroy(&g_mtx);
+}
+
+bool favorites_has(const char *path) {
+    bool ret = false;
+
+    mtx_lock(&g_mtx);
+
+    if (g_slots_cap != 0)
+        ret = is_set(*find_slot(path));
+
+    mtx_unlock(&g_mtx);
+
+    return ret;
+}
+
+void favorites_set(const char *path, bool fav) {
+    mtx_lock(&g_mtx);
+    set_locked(path, strlen(path), fav);
+    mtx_unlock(&g_mtx);
+}
+
+static lv_res_t write_favorites(FILE *fp, void *arg) {
+    for (size_t i = 0; i < g_slots_cap; i++) {
+        if (is_set(g_slots[i]) && fprintf(fp, "%s\n", g_slots[i]) < 0)
+            return LV_RES_INV;
+    }
+
+    return LV_RES_OK;
+}
+
+lv_res_t favorites_flush() {
+    mtx_lock(&g_mtx);
+
+    // Held back until the old .star files were all picked up, or the next start would skip the rest of them
+    if (!g_dirty || g_migrating) {
+        mtx_unlock(&g_mtx);
+        return LV_RES_OK;
+    }
+
+    lv_res_t res = save_file(FAVORITES_PATH, write_favorites, NULL);
+    if (res == LV_RES_OK)
+        g_dirty = false;
+
+    mtx_unlock(&g_mtx);
+
+    return res;
+}
+
+bool favorites_migrating() {
+    mtx_lock(&g_mtx);
+    bool ret = g_migrating;
+    mtx_unlock(&g_mtx);
+
+    return ret;
+}
+
+void favorites_migration_done() {
+    mtx_lock(&g_mtx);
+
+    if (!g_migrating) {
+        mtx_unlock(&g_mtx);
+        return;
+    }
+
+    g_migrating = false;
+    g_dirty = true; // Write the file even if it's empty so this doesn't happen again
+
+    mtx_unlock(&g_mtx);
+
+    if (favorites_flush() != LV_RES_OK) {
+        logPrintf("failed to write favorites, keeping the .star files\n");
+        return;
+    }
+
+    // Only now that they're safely in the file can the old .star files go
+    mtx_lock(&g_mtx);
+
+    for (size_t i = 0; i < g_slots_cap; i++) {
+        if (!is_set(g_slots[i]))
+            continue;
+
+        char star_path[PATH_MAX + 1];
+        app_entry_get_star_path(g_slots[i], star_path);
+        remove(star_path);
+    }
+
+    mtx_unlock(&g_mtx);
+}
\ No newline at end of file
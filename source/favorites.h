@@ -0,0 +1,23 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+
+#include "settings.h"
+
+#define FAVORITES_PATH SETTINGS_DIR "/favorites.txt"
+
+lv_res_t favorites_init();
+void favorites_exit();
+
+bool favorites_has(const char *path);
+void favorites_set(const char *path, bool fav);
+
+// Writes the set out if it changed, toggles are otherwise written in batches by a task
+lv_res_t favorites_flush();
+
+/*
+ * True until the first scan after the favorites file went missing is
+ * over, the scan picks up the old .star files while this is set.
+ */
+bool favorites_migrating();
+void favorites_migration_done();
\ No newline at end of file
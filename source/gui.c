@@ -1,13 +1,18 @@
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <threads.h>
 #include <lvgl/lvgl.h>
 
 #include "gui.h"
 #include "log.h"
 #include "decoder.h"
+#include "icon_loader.h"
 #include "drivers.h"
 #include "apps.h"
+#include "catalog.h"
+#include "search.h"
 #include "remote.h"
 #include "remote_net.h"
 #include "limitations.h"
@@ -15,6 +20,7 @@
 #include "settings.h"
 #include "theme.h"
 #include "text.h"
+#include "thumbs.h"
 #include "util.h"
 
 enum {
@@ -28,8 +34,30 @@ enum {
     DialogButton_max
 };
 
-static lv_ll_t g_apps_ll;
-static int g_apps_ll_len;
+static catalog_t g_catalog;
+
+static thrd_t g_scan_thread;
+static mtx_t g_scan_mtx;
+static lv_task_t *g_scan_task = NULL;
+static catalog_t g_scan_pending; // Filled by the scan thread, merged into g_catalog by g_scan_task
+static bool g_scan_done = false;
+static bool g_scan_complete = false; // Saw every app, as opposed to being cut short
+static bool g_scan_cancel = false;
+static u64 g_scan_start_tick;
+
+static search_t g_search;
+static bool g_search_stale = true; // The catalog changed since the search index was built
+static char g_search_text[SEARCH_QUERY_LEN] = {0};
+static lv_obj_t *g_search_cover = NULL;
+static lv_obj_t *g_search_label = NULL;
+static lv_obj_t *g_search_kb = NULL;
+static const char *g_search_kb_map[] = {
+    "1", "2", "3", "4", "5", "6", "7", "8", "9", "0", LV_SYMBOL_LEFT, "\n",
+    "q", "w", "e", "r", "t", "y", "u", "i", "o", "p", "\n",
+    "a", "s", "d", "f", "g", "h", "j", "k", "l", "\n",
+    "z", "x", "c", "v", "b", "n", "m", "-", ".", "\n",
+    NULL, LV_SYMBOL_OK, "" // The space key's label is filled in from the language
+};
 
 static lv_obj_t *g_curr_focused_tmp = NULL;
 
@@ -39,6 +67,10 @@ static lv_obj_t *g_list_buttons_tmp[MAX_LIST_ROWS] = {0};
 static lv_obj_t *g_list_covers[MAX_LIST_ROWS] = {0}; // Needed because when objects are direct children of an imgbtn, they're always centered (don't know why)
 static lv_obj_t *g_list_covers_tmp[MAX_LIST_ROWS] = {0};
 
+// Hold the small icon, showing a placeholder until the icon loader has it
+static lv_obj_t *g_list_icons[MAX_LIST_ROWS] = {0};
+static lv_obj_t *g_list_icons_tmp[MAX_LIST_ROWS] = {0};
+
 static lv_obj_t *g_dialog_buttons[DialogButton_max] = {0};
 static lv_obj_t *g_dialog_cover = NULL;
 static app_entry_t *g_dialog_entry = NULL;
@@ -53,6 +85,12 @@ static lv_anim_t g_page_arrow_anims[2] = {0};
 static bool g_page_list_anim_running = false;
 static bool g_page_arrow_anim_running = false;
 
+// Icons of the pages around the current one are loaded ahead of time, leaning the way the list was last paged
+static lv_task_t *g_prefetch_task = NULL;
+static bool g_prefetch_pending = false;
+static int g_last_page_dir = 1;
+static int g_recent_pages[RECENT_PAGES] = {-1, -1};
+
 static thrd_t g_remote_thread;
 static remote_loader_t *g_remote_loader;
 static lv_obj_t *g_remote_cover = NULL;
@@ -71,52 +109,203 @@ static const char *g_ok_btns[] = {NULL, ""};
 
 static void change_page(int dir);
 static void draw_buttons();
+static void draw_arrow_button(int idx);
 
 static void gen_apps_list() {
-    app_entry_ll_init(&g_apps_ll);
-    g_apps_ll_len = lv_ll_get_len(&g_apps_ll);
+    u64 start_tick = armGetSystemTick();
+
+    if (catalog_scan(&g_catalog) == LV_RES_OK)
+        thumbs_reclaim(&g_catalog);
+
+    logPrintf("scan took %lluus for %d apps\n", armTicksToNs(armGetSystemTick() - start_tick) / 1000, g_catalog.len);
+}
+
+// The list pages through the search results while there's a query, and the whole catalog otherwise
+static inline int view_len() {
+    return search_active(&g_search) ? g_search.num_results : g_catalog.len;
+}
+
+static app_entry_t *view_get(int idx) {
+    if (!search_active(&g_search))
+        return catalog_get(&g_catalog, idx);
+
+    if (idx < 0 || idx >= g_search.num_results)
+        return NULL;
+
+    return g_search.results[idx];
+}
+
+static int view_find(app_entry_t *entry) {
+    if (!search_active(&g_search))
+        return catalog_find(&g_catalog, entry);
+
+    for (int i = 0; i < g_search.num_results; i++) {
+        if (g_search.results[i] == entry)
+            return i;
+    }
+
+    return -1;
+}
+
+// Entries were added to or removed from the catalog
+static void catalog_changed() {
+    if (search_active(&g_search)) {
+        search_build(&g_search, &g_catalog);
+        g_search_stale = false;
+    } else {
+        g_search_stale = true;
+    }
 }
 
 static inline int num_buttons() {
-    return fmin(g_apps_ll_len - MAX_LIST_ROWS * g_curr_page, MAX_LIST_ROWS);
+    return fmin(view_len() - MAX_LIST_ROWS * g_curr_page, MAX_LIST_ROWS);
 }
 
 static inline bool on_last_page() {
-    return g_apps_ll_len - ((g_curr_page + 1) * MAX_LIST_ROWS) <= 0;
+    return view_len() - ((g_curr_page + 1) * MAX_LIST_ROWS) <= 0;
 }
 
 static app_entry_t *get_app_for_button(int btn_idx) {
-    app_entry_t *entry;
-    int i = 0;
+    return view_get(g_curr_page * MAX_LIST_ROWS + btn_idx);
+}
+
+// The whole page at once, so the thumbnails come in as few reads as possible
+static void request_page_icons() {
+    app_entry_t *entries[MAX_LIST_ROWS];
+
+    for (int i = 0; i < num_buttons(); i++)
+        entries[i] = get_app_for_button(i);
+
+    icon_loader_request(entries, num_buttons());
+}
+
+static void show_icon(lv_obj_t *holder, app_entry_t *entry) {
+    lv_obj_set_style(holder, &g_transp_style);
+
+    // The preview is already up when the full icon comes in
+    lv_obj_t *icon_small = lv_obj_get_child(holder, NULL);
+    if (icon_small == NULL)
+        icon_small = lv_img_create(holder, NULL);
+
+    lv_img_set_src(icon_small, &entry->icon_small);
+}
+
+static int get_page_entries(int page, app_entry_t **entries) {
+    int num = 0;
+
+    if (page < 0)
+        return 0;
 
-    btn_idx = g_curr_page * MAX_LIST_ROWS + btn_idx;
+    for (int i = 0; i < MAX_LIST_ROWS; i++) {
+        app_entry_t *entry = view_get(page * MAX_LIST_ROWS + i);
+        if (entry == NULL)
+            break;
 
-    LV_LL_READ(g_apps_ll, entry) {
-        if (i == btn_idx)
-            return entry;
-        i++;
+        entries[num++] = entry;
     }
 
-    return NULL;
+    return num;
 }
 
-static void free_current_app_icons() {
-    app_entry_t *entry = get_app_for_button(0);
+// Nearest first, then whatever was left recently
+static int get_warm_pages(int *pages) {
+    int num = 0;
+
+    pages[num++] = g_curr_page;
+
+    for (int dist = 1; dist <= PREFETCH_PAGES; dist++) {
+        pages[num++] = g_curr_page + dist * g_last_page_dir;
+        pages[num++] = g_curr_page - dist * g_last_page_dir;
+    }
+
+    for (int i = 0; i < RECENT_PAGES; i++)
+        pages[num++] = g_recent_pages[i];
+
+    return num;
+}
+
+// Walks the whole catalog rather than remembering what was loaded, pages shift whenever the list changes
+static void trim_icons() {
+    int pages[1 + 2 * PREFETCH_PAGES + RECENT_PAGES];
+    int num_pages = get_warm_pages(pages);
+
+    app_entry_t *keep[(1 + 2 * PREFETCH_PAGES + RECENT_PAGES) * MAX_LIST_ROWS];
+    int num_keep = 0;
+
+    for (int i = 0; i < num_pages; i++)
+        num_keep += get_page_entries(pages[i], &keep[num_keep]);
 
+    for (int i = 0; i < g_catalog.len; i++) {
+        app_entry_t *entry = g_catalog.entries[i];
+        if ((entry->icon_small.data == NULL && entry->icon.data == NULL) || entry == g_dialog_entry)
+            continue;
+
+        bool kept = false;
+        for (int j = 0; j < num_keep && !kept; j++)
+            kept = keep[j] == entry;
+
+        if (!kept)
+            app_entry_free_icon(entry);
+    }
+}
+
+static void prefetch_task(lv_task_t *task) {
+    // Only once the page is settled and its own icons are in
+    if (!g_prefetch_pending || g_page_list_anim_running || g_page_arrow_anim_running || lv_task_get_idle() < PREFETCH_MIN_IDLE || icon_loader_busy())
+        return;
+
+    g_prefetch_pending = false;
+
+    trim_icons();
+
+    int pages[1 + 2 * PREFETCH_PAGES + RECENT_PAGES];
+    int num_pages = get_warm_pages(pages);
+
+    // The current page and the recent ones are already loaded
+    for (int i = 1; i < 1 + 2 * PREFETCH_PAGES && i < num_pages; i++) {
+        app_entry_t *entries[MAX_LIST_ROWS];
+        int num = get_page_entries(pages[i], entries);
+
+        icon_loader_prefetch(entries, num);
+    }
+}
+
+static void icon_ready_cb(app_entry_t *entry) {
     for (int i = 0; i < num_buttons(); i++) {
-        app_entry_free_icon(entry);
-        entry = lv_ll_get_next(&g_apps_ll, entry);
+        if (get_app_for_button(i) != entry)
+            continue;
+
+        // While the page slides in its rows are still the tmp ones
+        lv_obj_t *holder = (g_list_icons_tmp[i] != NULL) ? g_list_icons_tmp[i] : g_list_icons[i];
+        if (holder != NULL)
+            show_icon(holder, entry);
+
+        return;
     }
 }
 
+static void free_current_app_icons() {
+    icon_loader_cancel();
+
+    for (int i = 0; i < num_buttons(); i++)
+        app_entry_free_icon(get_app_for_button(i));
+}
+
 static void del_buttons() {
-    for (int i = 0; i < num_buttons(); i++) {
+    for (int i = 0; i < MAX_LIST_ROWS; i++) {
+        if (g_list_buttons[i] == NULL)
+            continue;
+
         lv_obj_del(g_list_buttons[i]);
 
         g_list_buttons[i] = NULL;
         g_list_covers[i] = NULL;
+        g_list_icons[i] = NULL;
     }
 
+    // The entries of the page may be about to go away
+    icon_loader_cancel();
+
     for (int i = 0; i < 2; i++) {
         if (g_arrow_buttons[i] == NULL)
             continue;
@@ -126,38 +315,197 @@ static void del_buttons() {
     }
 }
 
-static void reset_menu_focused_on(char *path) {
-    del_buttons();
-    free_current_app_icons();
+static bool scan_entry_cb(app_entry_t *entry, void *arg) {
+    mtx_lock(&g_scan_mtx);
+
+    if (g_scan_cancel) {
+        mtx_unlock(&g_scan_mtx);
+        free(entry);
+        return false;
+    }
 
-    char entry_path[PATH_MAX + 1];
-    strncpy(entry_path, path, PATH_MAX);
-    entry_path[PATH_MAX] = '\0';
+    if (catalog_append(&g_scan_pending, entry) != LV_RES_OK)
+        free(entry);
 
-    lv_ll_clear(&g_apps_ll);
-    gen_apps_list();
+    mtx_unlock(&g_scan_mtx);
 
-    int i = 0;
-    app_entry_t *tmp_entry;
-    LV_LL_READ(g_apps_ll, tmp_entry) {
-        if (strcmp(entry_path, tmp_entry->path) == 0)
-            break;
+    return true;
+}
+
+static int scan_thread(void *arg) {
+    lv_res_t res = app_entry_scan(scan_entry_cb, NULL);
 
-        i++;
+    mtx_lock(&g_scan_mtx);
+    g_scan_done = true;
+    g_scan_complete = res == LV_RES_OK;
+    mtx_unlock(&g_scan_mtx);
+
+    return 0;
+}
+
+// Moves everything the scan thread found so far into the catalog, returns the lowest index that changed
+static int drain_scan_pending(bool *done) {
+    int first_changed;
+
+    mtx_lock(&g_scan_mtx);
+
+    if (catalog_merge(&g_catalog, g_scan_pending.entries, g_scan_pending.len, &first_changed) != LV_RES_OK) {
+        for (int i = 0; i < g_scan_pending.len; i++)
+            free(g_scan_pending.entries[i]);
     }
 
-    g_curr_page = i / MAX_LIST_ROWS;
+    if (g_scan_pending.len > 0)
+        g_search_stale = true;
+
+    g_scan_pending.len = 0;
+    *done = g_scan_done;
+
+    mtx_unlock(&g_scan_mtx);
+
+    return first_changed;
+}
+
+static void end_scan() {
+    thrd_join(g_scan_thread, NULL);
+
+    lv_task_del(g_scan_task);
+    g_scan_task = NULL;
+
+    catalog_clear(&g_scan_pending);
+
+    mtx_destroy(&g_scan_mtx);
+
+    if (g_scan_complete)
+        thumbs_reclaim(&g_catalog);
+
+    logPrintf("scan took %lluus for %d apps\n", armTicksToNs(armGetSystemTick() - g_scan_start_tick) / 1000, g_catalog.len);
+}
+
+// Blocks until the background scan is over, for actions that need the full list
+static void finish_scan() {
+    if (g_scan_task == NULL)
+        return;
+
+    // The callers redraw the page anyway, and the entries on it are about to shift
+    free_current_app_icons();
+
+    bool done;
+    do {
+        drain_scan_pending(&done);
+
+        struct timespec sleep = {.tv_nsec = 10000000};
+        thrd_sleep(&sleep, NULL);
+    } while (!done);
+
+    drain_scan_pending(&done);
+    end_scan();
+}
+
+static void redraw_page(int old_num_buttons, int num_inserted) {
+    int focus_idx = g_list_index;
+
+    del_buttons();
+
+    // The entries that were on screen have shifted by at most num_inserted
+    for (int i = 0; i < old_num_buttons + num_inserted; i++) {
+        app_entry_t *entry = get_app_for_button(i);
+        if (entry != NULL)
+            app_entry_free_icon(entry);
+    }
 
     draw_buttons();
 
-    lv_group_focus_obj(g_list_buttons[i % MAX_LIST_ROWS]);
+    if (focus_idx >= 0 && focus_idx < num_buttons())
+        lv_group_focus_obj(g_list_buttons[focus_idx]);
+    else if (focus_idx < 0 && g_arrow_buttons[focus_idx + 3] != NULL)
+        lv_group_focus_obj(g_arrow_buttons[focus_idx + 3]);
+}
+
+static void scan_task(lv_task_t *task) {
+    // The page and dialog hold on to entries by position, so wait for them to settle
+    if (g_page_list_anim_running || g_page_arrow_anim_running || g_dialog_cover != NULL || g_search_cover != NULL)
+        return;
+
+    int old_len = g_catalog.len;
+    int old_num_buttons = (g_list_buttons[0] != NULL) ? num_buttons() : 0;
+
+    bool done;
+    int first_changed = drain_scan_pending(&done);
+
+    if (g_list_buttons[0] == NULL) {
+        // Show the first page as soon as it's full, or whatever there is once the scan is over
+        if (g_catalog.len >= MAX_LIST_ROWS || done)
+            draw_buttons();
+    } else if (first_changed < (g_curr_page + 1) * MAX_LIST_ROWS) {
+        redraw_page(old_num_buttons, g_catalog.len - old_len);
+    } else if (g_arrow_buttons[0] == NULL && !on_last_page()) {
+        draw_arrow_button(0);
+    }
+
+    if (done)
+        end_scan();
+}
+
+static void start_scan() {
+    catalog_init(&g_catalog);
+    catalog_init(&g_scan_pending);
+
+    g_scan_done = false;
+    g_scan_complete = false;
+    g_scan_cancel = false;
+    g_scan_start_tick = armGetSystemTick();
+    mtx_init(&g_scan_mtx, mtx_plain);
+
+    if (thrd_create(&g_scan_thread, scan_thread, NULL) != thrd_success) {
+        mtx_destroy(&g_scan_mtx);
+
+        gen_apps_list();
+        draw_buttons();
+
+        return;
+    }
+
+    g_scan_task = lv_task_create(scan_task, 20, LV_TASK_PRIO_MID, NULL);
 }
 
 static void focus_cb(lv_group_t *group, lv_style_t *style) { }
 
+// Closes the dialog ahead of a change to the catalog, the page gets rebuilt afterwards so
+// nothing is put back in the keypad group
+static void drop_dialog() {
+    lv_obj_del(g_dialog_cover);
+    g_dialog_cover = NULL;
+    theme_unuse(ThemeLazy_dialog);
+
+    g_dialog_entry = NULL;
+    g_curr_focused_tmp = NULL;
+
+    for (int i = 0; i < DialogButton_max; i++)
+        g_dialog_buttons[i] = NULL;
+
+    // The entries on the page are about to shift, so let go of their icons while we still know which they are
+    del_buttons();
+    free_current_app_icons();
+}
+
+static void draw_page_focused_on(int idx) {
+    if (idx >= view_len())
+        idx = view_len() - 1;
+    if (idx < 0)
+        idx = 0;
+
+    g_curr_page = idx / MAX_LIST_ROWS;
+
+    draw_buttons();
+
+    if (g_list_buttons[idx % MAX_LIST_ROWS] != NULL)
+        lv_group_focus_obj(g_list_buttons[idx % MAX_LIST_ROWS]);
+}
+
 static void exit_dialog() {
     lv_obj_del(g_dialog_cover);
     g_dialog_cover = NULL;
+    theme_unuse(ThemeLazy_dialog);
 
     g_dialog_entry = NULL;
 
@@ -231,35 +579,43 @@ static void dialog_button_event(lv_obj_t *obj, lv_event_t event) {
 
             switch (btn_idx) {
                 case DialogButton_delete: {
-                    app_entry_delete(g_dialog_entry);
+                    app_entry_t *entry = g_dialog_entry;
+                    int idx = catalog_find(&g_catalog, entry);
+                    int view_idx = view_find(entry);
 
-                    lv_obj_del(g_dialog_cover);
-                    g_dialog_cover = NULL;
+                    drop_dialog();
 
-                    del_buttons();
-                    free_current_app_icons();
+                    // Deleting clears the star first, so the entry might have moved even if the rest failed
+                    if (app_entry_delete(entry) == LV_RES_OK) {
+                        catalog_remove(&g_catalog, idx);
+                        catalog_changed();
+                    } else {
+                        catalog_rekey(&g_catalog, idx);
+                        catalog_changed();
 
-                    lv_ll_clear(&g_apps_ll);
-                    gen_apps_list();
+                        view_idx = view_find(entry);
+                    }
 
-                    if (num_buttons() <= 0)
-                        g_curr_page--;
-
-                    draw_buttons();
+                    draw_page_focused_on(view_idx);
                 } break;
 
                 case DialogButton_load: {
                     logPrintf("g_dialog_entry(path(%s))\n", g_dialog_entry->path);
-                    app_entry_load(g_dialog_entry);
+                    app_entry_load(g_dialog_entry, NULL);
                 } break;
 
                 case DialogButton_star: {
-                    app_entry_set_star(g_dialog_entry, !g_dialog_entry->starred);
+                    app_entry_t *entry = g_dialog_entry;
+                    int idx = catalog_find(&g_catalog, entry);
+
+                    drop_dialog();
 
-                    lv_obj_del(g_dialog_cover);
-                    g_dialog_cover = NULL;
+                    app_entry_set_star(entry, !entry->starred);
 
-                    reset_menu_focused_on(g_dialog_entry->path);
+                    catalog_rekey(&g_catalog, idx);
+                    catalog_changed();
+
+                    draw_page_focused_on(view_find(entry));
                 } break;
                 
                 case DialogButton_back: {
@@ -279,13 +635,18 @@ static void draw_app_dialog() {
     lv_obj_set_style(g_dialog_cover, &curr_theme()->dark_opa_64_style);
     lv_obj_set_size(g_dialog_cover, LV_HOR_RES_MAX, LV_VER_RES_MAX);
 
+    theme_t *theme = theme_use(ThemeLazy_dialog);
+
     lv_obj_t *dialog_bg = lv_img_create(g_dialog_cover, NULL);
-    lv_img_set_src(dialog_bg, &curr_theme()->dialog_bg_dsc);
+    lv_img_set_src(dialog_bg, &theme->dialog_bg_dsc);
 
     lv_obj_align(dialog_bg, NULL, LV_ALIGN_CENTER, 0, 0);
 
     g_dialog_entry = get_app_for_button(g_list_index);
 
+    // Thumbnails don't need the JPEG, so it's only loaded for the big icon here
+    app_entry_init_icon(g_dialog_entry);
+
     lv_obj_t *name = lv_label_create(dialog_bg, NULL);
     lv_obj_set_style(name, &curr_theme()->normal_48_style);
     lv_label_set_align(name, LV_LABEL_ALIGN_CENTER);
@@ -325,8 +686,8 @@ static void draw_app_dialog() {
     lv_label_set_static_text(auth_2, g_dialog_entry->author);
 
     g_dialog_buttons[0] = lv_imgbtn_create(dialog_bg, NULL);
-    lv_imgbtn_set_src(g_dialog_buttons[0], LV_BTN_STATE_REL, &curr_theme()->dialog_btns_dscs[0]);
-    lv_imgbtn_set_src(g_dialog_buttons[0], LV_BTN_STATE_PR, &curr_theme()->dialog_btns_dscs[0]);
+    lv_imgbtn_set_src(g_dialog_buttons[0], LV_BTN_STATE_REL, &theme->dialog_btns_dscs[0]);
+    lv_imgbtn_set_src(g_dialog_buttons[0], LV_BTN_STATE_PR, &theme->dialog_btns_dscs[0]);
     lv_group_add_obj(keypad_group(), g_dialog_buttons[0]);
     lv_obj_set_event_cb(g_dialog_buttons[0], dialog_button_event);
     lv_obj_align(g_dialog_buttons[0], NULL, LV_ALIGN_IN_BOTTOM_LEFT, 40, -20);
@@ -356,6 +717,150 @@ static void draw_app_dialog() {
     lv_group_focus_obj(g_dialog_buttons[DialogButton_load]);
 }
 
+static void update_search_label() {
+    const char *fmt = text_get(StrId_search);
+    char text[strlen(fmt) + SEARCH_QUERY_LEN];
+    snprintf(text, sizeof(text), fmt, g_search_text);
+
+    lv_label_set_text(g_search_label, text);
+}
+
+// Filters the list as the query is typed, the keyboard keeps the focus
+static void apply_search() {
+    free_current_app_icons();
+    del_buttons();
+
+    search_query(&g_search, g_search_text);
+
+    g_curr_page = 0;
+    draw_buttons();
+
+    lv_group_remove_all_objs(keypad_group());
+    lv_group_add_obj(keypad_group(), g_search_kb);
+    lv_group_focus_obj(g_search_kb);
+
+    update_search_label();
+}
+
+static void close_search() {
+    lv_obj_del(g_search_cover);
+    g_search_cover = NULL;
+    g_search_label = NULL;
+    g_search_kb = NULL;
+
+    // Leaving with nothing on screen would leave nothing to focus either
+    if (search_active(&g_search) && g_search.num_results == 0) {
+        g_search_text[0] = '\0';
+
+        free_current_app_icons();
+        del_buttons();
+
+        search_query(&g_search, g_search_text);
+
+        g_curr_page = 0;
+        draw_buttons();
+
+        return;
+    }
+
+    for (int i = 0; i < num_buttons(); i++) {
+        lv_group_add_obj(keypad_group(), g_list_buttons[i]);
+        lv_event_send(g_list_buttons[i], LV_EVENT_DEFOCUSED, NULL);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (g_arrow_buttons[i] != NULL)
+            lv_group_add_obj(keypad_group(), g_arrow_buttons[i]);
+    }
+
+    if (g_list_buttons[0] != NULL)
+        lv_group_focus_obj(g_list_buttons[0]);
+}
+
+static void search_kb_event(lv_obj_t *obj, lv_event_t event) {
+    switch (event) {
+        case LV_EVENT_VALUE_CHANGED: {
+            const char *key = lv_btnm_get_active_btn_text(obj);
+            if (key == NULL || strcmp(key, LV_SYMBOL_OK) == 0)
+                return;
+
+            size_t len = strlen(g_search_text);
+
+            if (strcmp(key, LV_SYMBOL_LEFT) == 0) {
+                if (len == 0)
+                    return;
+
+                g_search_text[len - 1] = '\0';
+            } else {
+                const char *c = (strcmp(key, text_get(StrId_space)) == 0) ? " " : key;
+
+                if (len + strlen(c) >= SEARCH_QUERY_LEN)
+                    return;
+
+                strcat(g_search_text, c);
+            }
+
+            apply_search();
+        } break;
+
+        // Closing from the press itself would pull the keyboard out from under its own release
+        case LV_EVENT_CLICKED: {
+            const char *key = lv_btnm_get_active_btn_text(obj);
+            if (key != NULL && strcmp(key, LV_SYMBOL_OK) == 0)
+                close_search();
+        } break;
+
+        case LV_EVENT_KEY: {
+            const u32 *key = lv_event_get_data();
+            if (*key == KEYPAD_KEY_SEARCH)
+                close_search();
+        } break;
+
+        case LV_EVENT_CANCEL: {
+            close_search();
+        } break;
+    }
+}
+
+static void open_search() {
+    if (g_search_cover != NULL || g_dialog_cover != NULL || g_page_list_anim_running || g_page_arrow_anim_running)
+        return;
+
+    // The index covers the whole catalog, so the scan has to be done first
+    free_current_app_icons();
+    del_buttons();
+
+    finish_scan();
+
+    if (g_search_stale) {
+        search_build(&g_search, &g_catalog);
+        g_search_stale = false;
+    }
+
+    g_search_cover = lv_obj_create(lv_scr_act(), NULL);
+    lv_obj_set_style(g_search_cover, &curr_theme()->search_kb_bg_style);
+    lv_obj_set_size(g_search_cover, LIST_BTN_W, SEARCH_KB_H);
+    lv_obj_align(g_search_cover, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, 0);
+
+    g_search_label = lv_label_create(g_search_cover, NULL);
+    lv_label_set_long_mode(g_search_label, LV_LABEL_LONG_CROP);
+    lv_obj_set_width(g_search_label, LIST_BTN_W - 20);
+    lv_obj_align(g_search_label, NULL, LV_ALIGN_IN_TOP_LEFT, 10, 10);
+
+    g_search_kb_map[sizeof(g_search_kb_map) / sizeof(g_search_kb_map[0]) - 3] = text_get(StrId_space);
+
+    g_search_kb = lv_btnm_create(g_search_cover, NULL);
+    lv_btnm_set_map(g_search_kb, g_search_kb_map);
+    lv_btnm_set_style(g_search_kb, LV_BTNM_STYLE_BG, &lv_style_transp_tight);
+    lv_btnm_set_style(g_search_kb, LV_BTNM_STYLE_BTN_REL, &curr_theme()->search_kb_btn_rel_style);
+    lv_btnm_set_style(g_search_kb, LV_BTNM_STYLE_BTN_PR, &curr_theme()->search_kb_btn_pr_style);
+    lv_obj_set_size(g_search_kb, LIST_BTN_W, SEARCH_KB_H - SEARCH_LABEL_H);
+    lv_obj_align(g_search_kb, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, 0);
+    lv_obj_set_event_cb(g_search_kb, search_kb_event);
+
+    apply_search();
+}
+
 static void list_button_event(lv_obj_t *obj, lv_event_t event) {
     if (keypad_group()->frozen)
         return;
@@ -400,6 +905,9 @@ static void list_button_event(lv_obj_t *obj, lv_event_t event) {
                 case LV_KEY_LEFT:
                     lv_group_focus_obj(g_arrow_buttons[1]);
                     return;
+                case KEYPAD_KEY_SEARCH:
+                    open_search();
+                    return;
                 default:
                     return;
             }
@@ -464,6 +972,9 @@ static void arrow_button_event(lv_obj_t *obj, lv_event_t event) {
                         lv_group_focus_obj(g_list_buttons[num_buttons() / 2]);
 
                     break;
+                case KEYPAD_KEY_SEARCH:
+                    open_search();
+                    break;
             }
         } break;
 
@@ -478,7 +989,8 @@ static void arrow_button_event(lv_obj_t *obj, lv_event_t event) {
     }
 }
 
-static void draw_entry_on_obj(lv_obj_t *obj, app_entry_t *entry) {
+// Returns the holder of the small icon
+static lv_obj_t *draw_entry_on_obj(lv_obj_t *obj, app_entry_t *entry) {
     u8 offset = (LIST_BTN_H - APP_ICON_SMALL_H) / 2;
 
     lv_obj_t *author = lv_label_create(obj, NULL);
@@ -491,10 +1003,16 @@ static void draw_entry_on_obj(lv_obj_t *obj, app_entry_t *entry) {
     lv_label_set_static_text(ver, entry->version);
     lv_obj_align(ver, NULL, LV_ALIGN_IN_TOP_RIGHT, -offset, offset);
     
-    lv_obj_t *icon_small = lv_img_create(obj, NULL);
-    lv_img_set_src(icon_small, &entry->icon_small);
+    lv_obj_t *icon_small = lv_obj_create(obj, NULL);
+    lv_obj_set_click(icon_small, false);
+    lv_obj_set_size(icon_small, APP_ICON_SMALL_W, APP_ICON_SMALL_H);
     lv_obj_align(icon_small, NULL, LV_ALIGN_IN_LEFT_MID, offset, 0);
 
+    if (entry->icon_small.data != NULL)
+        show_icon(icon_small, entry);
+    else
+        lv_obj_set_style(icon_small, &curr_theme()->icon_placeholder_style);
+
     if (entry->starred) {
         lv_obj_t *star = lv_img_create(obj, NULL);
         lv_img_set_src(star, &curr_theme()->star_dscs[0]);
@@ -507,6 +1025,8 @@ static void draw_entry_on_obj(lv_obj_t *obj, app_entry_t *entry) {
     lv_label_set_align(name, LV_LABEL_ALIGN_LEFT);
     lv_label_set_long_mode(name, LV_LABEL_LONG_CROP);
     lv_obj_align(name, icon_small, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+
+    return icon_small;
 }
 
 static void draw_arrow_button(int idx) {
@@ -531,10 +1051,7 @@ static void list_ready_cb(lv_anim_t *anim) {
 
     int anim_idx = (lv_obj_get_y(anim_obj) - (LV_VER_RES_MAX - LIST_BTN_H * MAX_LIST_ROWS) / 2) / LIST_BTN_H;
 
-    app_entry_t *entry = get_app_for_button(((dir < 0) ? MAX_LIST_ROWS : -MAX_LIST_ROWS) + anim_idx);
-
-    if (entry != NULL)
-        app_entry_free_icon(entry);
+    // The old page's icons stay loaded in case the list is paged back, trim_icons decides later
 
     if (g_list_buttons_tmp[anim_idx] != NULL) {
         lv_obj_set_parent(g_list_buttons_tmp[anim_idx], lv_scr_act());
@@ -553,9 +1070,11 @@ static void list_ready_cb(lv_anim_t *anim) {
 
     g_list_buttons[anim_idx] = g_list_buttons_tmp[anim_idx];
     g_list_covers[anim_idx] = g_list_covers_tmp[anim_idx];
+    g_list_icons[anim_idx] = g_list_icons_tmp[anim_idx];
 
     g_list_buttons_tmp[anim_idx] = NULL;
     g_list_covers_tmp[anim_idx] = NULL;
+    g_list_icons_tmp[anim_idx] = NULL;
 }
 
 static void arrow_ready_cb(lv_anim_t *anim) {
@@ -619,19 +1138,23 @@ static void change_page(int dir) {
         }
     }
 
-    app_entry_t *entry = get_app_for_button(((dir < 0) ? -1 : 1) * MAX_LIST_ROWS);
+    for (int i = RECENT_PAGES - 1; i > 0; i--)
+        g_recent_pages[i] = g_recent_pages[i - 1];
+
+    g_recent_pages[0] = g_curr_page;
+    g_last_page_dir = dir;
+
     g_curr_page += dir;
+    request_page_icons();
+    g_prefetch_pending = true;
+
     for (int i = 0; i < num_buttons(); i++) {
         g_list_buttons_tmp[i] = lv_imgbtn_create(anim_objs[i], g_list_buttons[0]);
         g_list_buttons_tmp[i]->group_p = keypad_group(); // Needed because sometimes the group_p member is set to NULL even though the copied object's isn't
 
         g_list_covers_tmp[i] = lv_obj_create(g_list_buttons_tmp[i], g_list_covers[0]);
 
-        if (i > 0)
-            entry = lv_ll_get_next(&g_apps_ll, entry);
-
-        app_entry_init_icon(entry);
-        draw_entry_on_obj(g_list_covers_tmp[i], entry);
+        g_list_icons_tmp[i] = draw_entry_on_obj(g_list_covers_tmp[i], get_app_for_button(i));
 
         lv_obj_align(g_list_buttons_tmp[i], anim_objs[i], (dir < 0) ? LV_ALIGN_IN_LEFT_MID : LV_ALIGN_IN_RIGHT_MID, 0, 0);
     }
@@ -669,6 +1192,10 @@ static void draw_buttons() {
     if (num_buttons() <= 0)
         g_curr_page = 0;
 
+    // Nothing matching a search isn't worth a message box, the query is right there
+    if (num_buttons() <= 0 && search_active(&g_search))
+        return;
+
     if (num_buttons() <= 0) {
         lv_obj_t *mbox = lv_mbox_create(lv_scr_act(), NULL);
         lv_mbox_set_style(mbox, LV_MBOX_STYLE_BG, &curr_theme()->no_apps_mbox_style);
@@ -695,17 +1222,16 @@ static void draw_buttons() {
     lv_obj_set_style(g_list_covers[0], &g_transp_style);
     lv_obj_set_size(g_list_covers[0], LIST_BTN_W, LIST_BTN_H);
 
-    app_entry_t *entry = get_app_for_button(0);
-    app_entry_init_icon(entry);
-    draw_entry_on_obj(g_list_covers[0], entry);
+    request_page_icons();
+    g_prefetch_pending = true;
+
+    g_list_icons[0] = draw_entry_on_obj(g_list_covers[0], get_app_for_button(0));
 
     for (int i = 1; i < num_buttons(); i++) {
         g_list_buttons[i] = lv_imgbtn_create(lv_scr_act(), g_list_buttons[i - 1]);
         g_list_covers[i] = lv_obj_create(g_list_buttons[i], g_list_covers[i - 1]);
 
-        entry = lv_ll_get_next(&g_apps_ll, entry);
-        app_entry_init_icon(entry);
-        draw_entry_on_obj(g_list_covers[i], entry);
+        g_list_icons[i] = draw_entry_on_obj(g_list_covers[i], get_app_for_button(i));
 
         lv_obj_align(g_list_buttons[i], g_list_buttons[i - 1], LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
     }
@@ -744,14 +1270,18 @@ void setup_menu() {
     g_transp_style.body.padding.top = 0;
     g_transp_style.body.padding.bottom = 0;
 
-    gen_apps_list();
-    draw_buttons();
+    search_init(&g_search);
+    icon_loader_init(icon_ready_cb);
+    g_prefetch_task = lv_task_create(prefetch_task, PREFETCH_PERIOD, LV_TASK_PRIO_LOWEST, NULL);
+
+    start_scan();
 }
 
 static void remote_cover_event_cb(lv_obj_t *obj, lv_event_t event) {
     switch (event) {
         case LV_EVENT_DELETE:
             g_remote_cover = NULL;
+            theme_unuse(ThemeLazy_remote);
             lv_group_focus_freeze(keypad_group(), false);
 
             struct timespec sleep = {.tv_nsec = 100000000};
@@ -799,7 +1329,7 @@ static void remote_progress_task(lv_task_t *task) {
             lv_bar_set_range(g_remote_bar, 0, 100);
 
             lv_obj_t *img = lv_img_create(g_remote_cover, NULL);
-            lv_img_set_src(img, &curr_theme()->remote_progress_dsc);
+            lv_img_set_src(img, &theme_use(ThemeLazy_remote)->remote_progress_dsc);
             lv_obj_align(img, g_remote_bar, LV_ALIGN_CENTER, 0, 0);
 
             g_remote_percent = lv_label_create(img, NULL);
@@ -817,7 +1347,7 @@ static void remote_progress_task(lv_task_t *task) {
         char receiving[receiving_size];
         receiving[0] = '\0';
 
-        snprintf(receiving, receiving_size, tmp_fmt, get_name(g_remote_loader->entry.path));
+        snprintf(receiving, receiving_size, tmp_fmt, get_name(g_remote_loader->path));
         lv_label_set_text(g_remote_name, receiving);
 
         char percent[8];
@@ -988,6 +1518,21 @@ void setup_misc() {
 }
 
 void gui_exit() {
+    if (g_scan_task != NULL) {
+        mtx_lock(&g_scan_mtx);
+        g_scan_cancel = true;
+        mtx_unlock(&g_scan_mtx);
+
+        finish_scan();
+    }
+
+    search_clear(&g_search);
+
+    lv_task_del(g_prefetch_task);
+    g_prefetch_task = NULL;
+
+    icon_loader_exit();
+
     if (curr_settings()->remote_type != RemoteLoaderType_disabled) {
         remote_loader_set_exit(g_remote_loader);
         logPrintf("thrd_join\n");
@@ -11,6 +11,14 @@
 
 #define ARROW_OFF (20 + (ARROW_BTN_W + LIST_BTN_W) / 2)
 
+#define PREFETCH_PAGES 2 // On either side of the current one
+#define RECENT_PAGES 2
+#define PREFETCH_PERIOD 50
+#define PREFETCH_MIN_IDLE 50 // Percent of the time lv_task_handler had nothing to do
+
+#define SEARCH_KB_H 240
+#define SEARCH_LABEL_H 48
+
 void setup_screen();
 void setup_menu();
 void setup_misc();
@@ -0,0 +1,354 @@
+#include <threads.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "icon_loader.h"
+#include "icon_store.h"
+#include "log.h"
+#include "thumbs.h"
+
+#define ICON_LOADER_POLL_PERIOD 20
+#define ICON_LOADER_SETTLE_TIME 150 // ms without a new request before previews are redone at full quality
+
+typedef enum {
+    IconJobState_pending,
+    IconJobState_running,
+    IconJobState_done,
+    IconJobState_previewed, // Waiting for the full decode
+    IconJobState_delivered,
+} IconJobState;
+
+typedef struct {
+    app_entry_t *entry; // Only dereferenced on the UI thread, and only while the job is current
+    app_entry_t snapshot; // What the workers read from instead, holds the JPEG between the preview and the full decode
+    u8 *data; // NULL if it failed
+    bool preview; // Decoded roughly first if there's no thumbnail
+    bool refined; // data is the final icon
+    IconJobState state;
+} icon_job_t;
+
+static mtx_t g_mtx;
+static cnd_t g_cnd;
+static thrd_t g_threads[ICON_LOADER_THREADS];
+static int g_num_threads = 0;
+static bool g_stop = false;
+
+// Bumped by every request, workers drop results of an older one
+static u32 g_gen = 0;
+
+static icon_job_t g_jobs[ICON_LOADER_MAX_JOBS];
+static int g_num_jobs = 0;
+
+// Full decodes of previewed icons wait until the requests stop coming
+static u64 g_request_tick = 0;
+static bool g_refine = false;
+
+// Thumbnails are looked up in batches before any decoding starts, jobs below g_num_read had theirs looked up
+static int g_num_read = 0;
+static bool g_reading = false;
+
+static icon_loader_ready_cb_t g_ready_cb = NULL;
+static lv_task_t *g_task = NULL;
+
+static void read_batch() {
+    u32 gen = g_gen;
+    int first = g_num_read;
+    int num = g_num_jobs - first;
+
+    app_entry_t snapshots[num];
+    app_entry_t *entries[num];
+    u8 *bufs[num];
+    bool have_bufs = true;
+
+    g_reading = true;
+
+    for (int i = 0; i < num; i++) {
+        snapshots[i] = g_jobs[first + i].snapshot;
+        entries[i] = &snapshots[i];
+
+        bufs[i] = icon_store_alloc(THUMB_SIZE);
+        if (bufs[i] == NULL)
+            have_bufs = false;
+    }
+
+    mtx_unlock(&g_mtx);
+
+    // Short on memory, so they all count as misses and get decoded one at a time instead
+    u32 found = have_bufs ? thumbs_read(entries, bufs, num) : 0;
+
+    // Apps with the same icon have the same thumbnail, one copy of it will do
+    for (int i = 0; i < num; i++) {
+        if (found & BIT(i))
+            bufs[i] = icon_store_intern(bufs[i]);
+    }
+
+    mtx_lock(&g_mtx);
+
+    for (int i = 0; i < num; i++) {
+        if (gen == g_gen && (found & BIT(i))) {
+            g_jobs[first + i].data = bufs[i];
+            g_jobs[first + i].refined = true;
+            g_jobs[first + i].state = IconJobState_done;
+        } else {
+            icon_store_release(bufs[i]);
+        }
+    }
+
+    if (gen == g_gen) {
+        g_num_read = first + num;
+        g_reading = false;
+        cnd_broadcast(&g_cnd);
+    }
+}
+
+static void decode_job(int idx) {
+    u32 gen = g_gen;
+    app_entry_t snapshot = g_jobs[idx].snapshot;
+    bool preview = g_jobs[idx].state == IconJobState_pending && g_jobs[idx].preview;
+
+    g_jobs[idx].state = IconJobState_running;
+
+    mtx_unlock(&g_mtx);
+
+    u8 *data = app_entry_decode_small_icon(&snapshot, &preview);
+
+    // Worth keeping even if the page is gone by now, it'll come up again
+    if (data != NULL && !preview)
+        thumbs_write(&snapshot, data);
+
+    if (!preview) {
+        icon_store_release(snapshot.icon.data);
+        snapshot.icon.data = NULL;
+    }
+
+    mtx_lock(&g_mtx);
+
+    if (gen != g_gen) {
+        icon_store_release(data);
+        icon_store_release(snapshot.icon.data);
+        return;
+    }
+
+    // The icon location may have been read from the file along the way
+    g_jobs[idx].snapshot.icon_offset = snapshot.icon_offset;
+    g_jobs[idx].snapshot.icon_size = snapshot.icon_size;
+    g_jobs[idx].snapshot.icon = snapshot.icon;
+
+    // A failed preview won't do any better at full quality
+    g_jobs[idx].data = data;
+    g_jobs[idx].refined = !preview || data == NULL;
+    g_jobs[idx].state = IconJobState_done;
+}
+
+static int find_job(IconJobState state) {
+    for (int i = 0; i < g_num_read; i++) {
+        if (g_jobs[i].state == state)
+            return i;
+    }
+
+    return -1;
+}
+
+static bool has_work() {
+    return find_job(IconJobState_pending) >= 0 || (!g_reading && g_num_read < g_num_jobs) || (g_refine && find_job(IconJobState_previewed) >= 0);
+}
+
+static void work_step() {
+    // What's queued first is decoded first, so a batch that came in later waits its turn. The full decodes go last
+    int idx = find_job(IconJobState_pending);
+
+    if (idx < 0 && !g_reading && g_num_read < g_num_jobs) {
+        read_batch();
+        return;
+    }
+
+    if (idx < 0)
+        idx = find_job(IconJobState_previewed);
+
+    decode_job(idx);
+}
+
+static int worker_thread(void *arg) {
+    // Keep off the UI thread's core so the page animation doesn't compete with decoding
+    int core = 1 + (int) (uintptr_t) arg % 2;
+    svcSetThreadCoreMask(CUR_THREAD_HANDLE, core, BIT(core));
+
+    mtx_lock(&g_mtx);
+
+    while (true) {
+        while (!g_stop && !has_work())
+            cnd_wait(&g_cnd, &g_mtx);
+
+        if (g_stop)
+            break;
+
+        work_step();
+    }
+
+    mtx_unlock(&g_mtx);
+
+    return 0;
+}
+
+static void poll_task(lv_task_t *task) {
+    app_entry_t *ready[ICON_LOADER_MAX_JOBS];
+    int num_ready = 0;
+
+    mtx_lock(&g_mtx);
+
+    if (!g_refine && armTicksToNs(armGetSystemTick() - g_request_tick) >= ICON_LOADER_SETTLE_TIME * 1000000ULL) {
+        g_refine = true;
+        cnd_broadcast(&g_cnd);
+    }
+
+    for (int i = 0; i < g_num_jobs; i++) {
+        icon_job_t *job = &g_jobs[i];
+        if (job->state != IconJobState_done)
+            continue;
+
+        job->state = job->refined ? IconJobState_delivered : IconJobState_previewed;
+
+        if (job->data == NULL)
+            continue;
+
+        job->entry->icon_offset = job->snapshot.icon_offset;
+        job->entry->icon_size = job->snapshot.icon_size;
+
+        app_entry_set_small_icon(job->entry, job->data);
+        job->data = NULL;
+
+        ready[num_ready++] = job->entry;
+    }
+
+    mtx_unlock(&g_mtx);
+
+    for (int i = 0; i < num_ready; i++)
+        g_ready_cb(ready[i]);
+}
+
+// Forgets the current jobs, whatever is still running for them is thrown away when it's done
+static void reset_jobs() {
+    for (int i = 0; i < g_num_jobs; i++) {
+        if (g_jobs[i].state == IconJobState_done)
+            icon_store_release(g_jobs[i].data);
+
+        // A running job's JPEG belongs to its worker
+        if (g_jobs[i].state != IconJobState_running)
+            icon_store_release(g_jobs[i].snapshot.icon.data);
+    }
+
+    g_gen++;
+    g_num_jobs = 0;
+    g_num_read = 0;
+    g_reading = false;
+
+    g_request_tick = armGetSystemTick();
+    g_refine = false;
+}
+
+static bool is_queued(app_entry_t *entry) {
+    for (int i = 0; i < g_num_jobs; i++) {
+        if (g_jobs[i].entry == entry)
+            return true;
+    }
+
+    return false;
+}
+
+static void queue_jobs(app_entry_t **entries, int num, bool preview) {
+    for (int i = 0; i < num && g_num_jobs < ICON_LOADER_MAX_JOBS; i++) {
+        if (entries[i] == NULL || entries[i]->icon_small.data != NULL || is_queued(entries[i]))
+            continue;
+
+        icon_job_t *job = &g_jobs[g_num_jobs++];
+
+        job->entry = entries[i];
+        job->snapshot = *entries[i];
+        job->snapshot.icon.data = NULL;
+        job->snapshot.icon_small.data = NULL;
+        job->data = NULL;
+        job->refined = false;
+        job->state = IconJobState_pending;
+
+        // Done in one go without workers, a preview would only hold things up
+        job->preview = preview && g_num_threads > 0;
+    }
+
+    // Without workers it's back to loading them right here
+    if (g_num_threads == 0) {
+        while (has_work())
+            work_step();
+    }
+
+    cnd_broadcast(&g_cnd);
+}
+
+void icon_loader_init(icon_loader_ready_cb_t ready_cb) {
+    g_ready_cb = ready_cb;
+    g_stop = false;
+
+    mtx_init(&g_mtx, mtx_plain);
+    cnd_init(&g_cnd);
+
+    while (g_num_threads < ICON_LOADER_THREADS && thrd_create(&g_threads[g_num_threads], worker_thread, (void *) (uintptr_t) g_num_threads) == thrd_success)
+        g_num_threads++;
+
+    if (g_num_threads == 0)
+        LV_LOG_WARN("No icon loader threads");
+
+    g_task = lv_task_create(poll_task, ICON_LOADER_POLL_PERIOD, LV_TASK_PRIO_MID, NULL);
+}
+
+void icon_loader_exit() {
+    if (g_task != NULL) {
+        lv_task_del(g_task);
+        g_task = NULL;
+    }
+
+    mtx_lock(&g_mtx);
+    g_stop = true;
+    reset_jobs();
+    cnd_broadcast(&g_cnd);
+    mtx_unlock(&g_mtx);
+
+    for (int i = 0; i < g_num_threads; i++)
+        thrd_join(g_threads[i], NULL);
+
+    g_num_threads = 0;
+
+    cnd_destroy(&g_cnd);
+    mtx_destroy(&g_mtx);
+}
+
+void icon_loader_request(app_entry_t **entries, int num) {
+    mtx_lock(&g_mtx);
+
+    reset_jobs();
+    queue_jobs(entries, num, true);
+
+    mtx_unlock(&g_mtx);
+}
+
+void icon_loader_prefetch(app_entry_t **entries, int num) {
+    mtx_lock(&g_mtx);
+    queue_jobs(entries, num, false);
+    mtx_unlock(&g_mtx);
+}
+
+void icon_loader_cancel() {
+    mtx_lock(&g_mtx);
+    reset_jobs();
+    mtx_unlock(&g_mtx);
+}
+
+bool icon_loader_busy() {
+    mtx_lock(&g_mtx);
+
+    bool busy = false;
+    for (int i = 0; i < g_num_jobs && !busy; i++)
+        busy = g_jobs[i].state != IconJobState_delivered;
+
+    mtx_unlock(&g_mtx);
+
+    return busy;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+
+#include "apps.h"
+
+#define ICON_LOADER_THREADS 2
+#define ICON_LOADER_MAX_JOBS 32
+
+typedef void (*icon_loader_ready_cb_t)(app_entry_t *entry);
+
+/*
+ * Loads small icons on worker threads, from the thumbnail file where it
+ * has them and by decoding the JPEG otherwise. ready_cb is called on the
+ * UI thread once an entry's small icon was set.
+ */
+void icon_loader_init(icon_loader_ready_cb_t ready_cb);
+void icon_loader_exit();
+
+/*
+ * Queues the entries that have no small icon yet, and cancels everything
+ * queued before. Icons that have to be decoded show up as a rough preview
+ * first, the full decodes wait until no request came in for a moment.
+ */
+void icon_loader_request(app_entry_t **entries, int num);
+
+// Queues more entries behind the current request, they're canceled along with it and decoded at full quality right away
+void icon_loader_prefetch(app_entry_t **entries, int num);
+
+void icon_loader_cancel();
+
+// Something queued hasn't been handed over yet
+bool icon_loader_busy();
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "icon_store.h"
+#include "log.h"
+
+// Sits in front of every buffer, 16 bytes apart from the data so pixels stay aligned
+typedef struct store_buf {
+    struct store_buf *next; // In the content table, if interned
+    struct store_buf *next_src; // In the source table, if decoded from an interned icon
+
+    u64 hash;
+    u64 src_hash;
+    size_t size;
+    size_t src_size;
+
+    u32 refs;
+    bool interned;
+    bool has_src;
+} __attribute__((aligned(16))) store_buf_t;
+
+static mtx_t g_mtx;
+static store_buf_t *g_by_content[ICON_STORE_BUCKETS] = {0};
+static store_buf_t *g_by_src[ICON_STORE_BUCKETS] = {0};
+static icon_store_stats_t g_stats = {0};
+static size_t g_pooled_size = 0;
+static store_buf_t *g_free = NULL;
+static u32 g_num_free = 0;
+
+static inline store_buf_t *get_header(const u8 *buf) {
+    return (store_buf_t *) buf - 1;
+}
+
+// 64 bits so the source of a decoded icon can be told apart without the source at hand
+static u64 hash_buf(const u8 *data, size_t size) {
+    u64 hash = 14695981039346656037ull; // FNV-1a
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash ^ size;
+}
+
+static void unlink_buf(store_buf_t **table, store_buf_t *header, u64 hash, bool by_src) {
+    store_buf_t **link = &table[hash % ICON_STORE_BUCKETS];
+
+    while (*link != NULL && *link != header)
+        link = by_src ? &(*link)->next_src : &(*link)->next;
+
+    if (*link != NULL)
+        *link = by_src ? header->next_src : header->next;
+}
+
+void icon_store_init(size_t pooled_size) {
+    g_pooled_size = pooled_size;
+
+    mtx_init(&g_mtx, mtx_plain);
+}
+
+void icon_store_exit() {
+    while (g_free != NULL) {
+        store_buf_t *next = g_free->next;
+        free(g_free);
+        g_free = next;
+    }
+
+    g_num_free = 0;
+
+    logPrintf("icon store: %u merged, %u decodes saved, %zu bytes saved\n", g_stats.merged, g_stats.decodes_saved, g_stats.bytes_saved);
+    logPrintf("icon store pool: %u allocs, %u reuses\n", g_stats.allocs, g_stats.reuses);
+
+    mtx_destroy(&g_mtx);
+}
+
+u8 *icon_store_alloc(size_t size) {
+    store_buf_t *header = NULL;
+
+    mtx_lock(&g_mtx);
+
+    if (size == g_pooled_size && g_free != NULL) {
+        header = g_free;
+        g_free = header->next;
+        g_num_free--;
+        g_stats.reuses++;
+    } else {
+        g_stats.allocs++;
+    }
+
+    mtx_unlock(&g_mtx);
+
+    if (header == NULL && (header = malloc(sizeof(store_buf_t) + size)) == NULL)
+        return NULL;
+
+    memset(header, 0, sizeof(store_buf_t));
+    header->size = size;
+    header->refs = 1;
+
+    return (u8 *) (header + 1);
+}
+
+void icon_store_release(const u8 *buf) {
+    if (buf == NULL)
+        return;
+
+    store_buf_t *header = get_header(buf);
+
+    mtx_lock(&g_mtx);
+
+    bool last = --header->refs == 0;
+
+    if (last && header->interned)
+        unlink_buf(g_by_content, header, header->hash, false);
+
+    if (last && header->has_src)
+        unlink_buf(g_by_src, header, header->src_hash, true);
+
+    bool pooled = last && header->size == g_pooled_size && g_num_free < ICON_STORE_MAX_FREE;
+
+    if (pooled) {
+        header->next = g_free;
+        g_free = header;
+        g_num_free++;
+    }
+
+    mtx_unlock(&g_mtx);
+
+    if (last && !pooled)
+        free(header);
+}
+
+u8 *icon_store_intern(u8 *buf) {
+    store_buf_t *header = get_header(buf);
+
+    // Hashed outside the lock, it's the slow part
+    u64 hash = hash_buf(buf, header->size);
+
+    mtx_lock(&g_mtx);
+
+    store_buf_t **bucket = &g_by_content[hash % ICON_STORE_BUCKETS];
+
+    for (store_buf_t *held = *bucket; held != NULL; held = held->next) {
+        if (held->hash != hash || held->size != header->size || memcmp(held + 1, buf, header->size) != 0)
+            continue;
+
+        held->refs++;
+
+        g_stats.merged++;
+        g_stats.bytes_saved += header->size;
+
+        mtx_unlock(&g_mtx);
+
+        icon_store_release(buf);
+
+        return (u8 *) (held + 1);
+    }
+
+    header->hash = hash;
+    header->interned = true;
+    header->next = *bucket;
+    *bucket = header;
+
+    mtx_unlock(&g_mtx);
+
+    return buf;
+}
+
+u8 *icon_store_find_decoded(const u8 *icon) {
+    store_buf_t *src = get_header(icon);
+    u8 *found = NULL;
+
+    mtx_lock(&g_mtx);
+
+    if (src->interned) {
+        for (store_buf_t *held = g_by_src[src->hash % ICON_STORE_BUCKETS]; held != NULL; held = held->next_src) {
+            if (held->src_hash == src->hash && held->src_size == src->size) {
+                held->refs++;
+                g_stats.decodes_saved++;
+
+                found = (u8 *) (held + 1);
+                break;
+            }
+        }
+    }
+
+    mtx_unlock(&g_mtx);
+
+    return found;
+}
+
+u8 *icon_store_add_decoded(u8 *decoded, const u8 *icon) {
+    decoded = icon_store_intern(decoded);
+
+    store_buf_t *header = get_header(decoded);
+    store_buf_t *src = get_header(icon);
+
+    mtx_lock(&g_mtx);
+
+    // A merged buffer may already stand for another icon, one source is enough to find it by
+    if (src->interned && !header->has_src) {
+        header->src_hash = src->hash;
+        header->src_size = src->size;
+        header->has_src = true;
+
+        store_buf_t **bucket = &g_by_src[src->hash % ICON_STORE_BUCKETS];
+        header->next_src = *bucket;
+        *bucket = header;
+    }
+
+    mtx_unlock(&g_mtx);
+
+    return decoded;
+}
+
+void icon_store_get_stats(icon_store_stats_t *stats) {
+    mtx_lock(&g_mtx);
+    *stats = g_stats;
+    mtx_unlock(&g_mtx);
+}
\ No newline at end of file
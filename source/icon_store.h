@@ -0,0 +1,44 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#define ICON_STORE_BUCKETS 256
+#define ICON_STORE_MAX_FREE 32
+
+typedef struct {
+    u32 merged; // Buffers that turned out to be a copy of one already held
+    u32 decodes_saved;
+    size_t bytes_saved;
+    u32 allocs; // Buffers that had to come from the heap
+    u32 reuses;
+} icon_store_stats_t;
+
+/*
+ * Refcounted icon buffers. Interned ones are merged with an identical
+ * buffer that's already held, so apps that ship the same icon end up
+ * sharing one copy of it, compressed and decoded. Any thread may use it.
+ */
+void icon_store_init(size_t pooled_size);
+void icon_store_exit();
+
+/*
+ * A private buffer with one reference. Up to ICON_STORE_MAX_FREE released
+ * buffers of pooled_size, what the small icons are decoded into, are kept
+ * and handed out again.
+ */
+u8 *icon_store_alloc(size_t size);
+void icon_store_release(const u8 *buf);
+
+// Returns the buffer to keep using, buf itself is released if an identical one was held already
+u8 *icon_store_intern(u8 *buf);
+
+/*
+ * Decoded icons are remembered by the interned compressed icon they were
+ * made from, for as long as anything holds on to them. find_decoded adds
+ * a reference for the caller.
+ */
+u8 *icon_store_find_decoded(const u8 *icon);
+u8 *icon_store_add_decoded(u8 *decoded, const u8 *icon);
+
+void icon_store_get_stats(icon_store_stats_t *stats);
\ No newline at end of file
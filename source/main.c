@@ -8,6 +8,7 @@
 #include "decoder.h"
 #include "gui.h"
 #include "settings.h"
+#include "apps.h"
 
 #ifdef MUSIC
 
@@ -49,6 +50,8 @@ int main(int argc, char **argv) {
     
     decoderInitialize();
 
+    app_entries_init();
+
     setup_screen();
     setup_menu();
     setup_misc();
@@ -68,6 +71,8 @@ int main(int argc, char **argv) {
     mtx_destroy(&g_loop_mtx);
 
     gui_exit();
+    decoderExit();
+    app_entries_exit();
 
     driversExit();
     theme_exit();
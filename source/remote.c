@@ -184,8 +184,9 @@ static int recv_app(remote_loader_t *r) {
 
     // Does the path need to be sanitized?
 
-    snprintf(r->entry.path, PATH_MAX + 1, APP_DIR "/%s", file_name);
-    app_entry_init_base(&r->entry, r->entry.path);
+    snprintf(r->path, PATH_MAX + 1, APP_DIR "/%s", file_name);
+    app_entry_init_base(&r->entry, r->path);
+    r->args[0] = '\0';
     logPrintf("path: %s\n", r->entry.path);
 
 
@@ -236,16 +237,16 @@ static int recv_app(remote_loader_t *r) {
                     char *args_buf_end = args_buf + args_len;
 
                     while (args_buf_tmp < args_buf_end) {
-                        if (app_entry_add_arg(&r->entry, args_buf_tmp) != LV_RES_OK)
+                        if (app_args_add(r->args, args_buf_tmp) != LV_RES_OK)
                             break;
 
                         args_buf_tmp += strlen(args_buf_tmp) + 1;
                     }
 
-                    logPrintf("args 1: %s\n", r->entry.args);
+                    logPrintf("args 1: %s\n", r->args);
                     if (r->add_args_cb != NULL)
                         r->add_args_cb(r); // For example the net loader would add the _NXLINK_ arg
-                    logPrintf("args 2: %s\n", r->entry.args);
+                    logPrintf("args 2: %s\n", r->args);
                 }
             }
         } else {
@@ -269,12 +270,12 @@ static int recv_app(remote_loader_t *r) {
                     logPrintf("tmp_path(%s)\n", tmp_path);
 
                     mkdirs(tmp_path, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-                    remove(r->entry.path);
-                    rename(TMP_APP_PATH, r->entry.path);
+                    replace_file(TMP_APP_PATH, r->entry.path);
                 } break;
 
                 case AppEntryType_theme: {
-                    strncpy(r->entry.path, TMP_APP_PATH, PATH_MAX);
+                    strncpy(r->path, TMP_APP_PATH, PATH_MAX);
+                    r->entry.path = r->path;
                 } break;
 
                 default: {
@@ -436,7 +437,7 @@ int remote_loader_thread(void *arg) {
         if (!remote_loader_get_exit(r)) {
             remote_loader_set_activated(r, true);
             if (recv_app(r) == 0) {
-                app_entry_load(&r->entry);
+                app_entry_load(&r->entry, r->args);
 
                 // If the app is a homebrew we want to exit as fast as possible
                 if (r->entry.type != AppEntryType_homebrew) {
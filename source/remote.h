@@ -59,6 +59,8 @@ typedef struct remote_loader {
     u8 flags;
 
     app_entry_t entry;
+    char path[PATH_MAX + 1];
+    char args[APP_ARGS_LEN]; // Passed after the path when loading the app
     size_t total, current;
 
     u8 in_buf[ZLIB_CHUNK];
@@ -0,0 +1,224 @@
+#include <math.h>
+#include <string.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "resample.h"
+
+// Weights are Q14, the intermediate rows keep 6 fractional bits so the second pass doesn't round twice
+#define WEIGHT_BITS 14
+#define INTER_BITS 6
+
+#define H_SHIFT (WEIGHT_BITS - INTER_BITS)
+#define V_SHIFT (WEIGHT_BITS + INTER_BITS)
+
+typedef struct {
+    u32 *start; // First source pixel of each output pixel
+    u16 *weights; // taps weights per output pixel, the unused ones are 0
+    u32 taps;
+} coeffs_t;
+
+static u32 num_taps(u32 src_len, u32 dst_len) {
+    u32 taps = (src_len > dst_len) ? (src_len + dst_len - 1) / dst_len + 1 : 2;
+
+    return (taps > src_len) ? src_len : taps;
+}
+
+// Every output pixel gets a fixed number of taps that never reach past the edge, so the loops don't have to check
+static void build_coeffs(coeffs_t *coeffs, u32 src_len, u32 dst_len) {
+    double scale = (double) src_len / (double) dst_len;
+    double contrib[coeffs->taps];
+
+    for (u32 i = 0; i < dst_len; i++) {
+        u32 first;
+        u32 count;
+
+        memset(contrib, 0, sizeof(contrib));
+
+        if (scale > 1.0) {
+            double lo = i * scale;
+            double hi = lo + scale;
+
+            first = lo;
+            u32 last = ceil(hi);
+            if (last > src_len)
+                last = src_len;
+
+            count = last - first;
+            if (count > coeffs->taps)
+                count = coeffs->taps;
+
+            for (u32 j = 0; j < count; j++) {
+                double from = (first + j > lo) ? first + j : lo;
+                double to = (first + j + 1 < hi) ? first + j + 1 : hi;
+
+                contrib[j] = (to > from) ? (to - from) / scale : 0.0;
+            }
+        } else {
+            double center = (i + 0.5) * scale - 0.5;
+            if (center < 0.0)
+                center = 0.0;
+            if (center > src_len - 1)
+                center = src_len - 1;
+
+            first = center;
+            double frac = center - first;
+
+            count = (first + 1 < src_len) ? 2 : 1;
+
+            contrib[0] = 1.0 - frac;
+            if (count == 2)
+                contrib[1] = frac;
+            else
+                contrib[0] = 1.0;
+        }
+
+        u32 start = (first + coeffs->taps > src_len) ? src_len - coeffs->taps : first;
+        u16 *weights = &coeffs->weights[i * coeffs->taps];
+
+        memset(weights, 0, coeffs->taps * sizeof(u16));
+
+        // Rounding can leave the sum off by a little, the biggest tap absorbs it so flat areas stay flat
+        int sum = 0;
+        u32 biggest = 0;
+
+        for (u32 j = 0; j < count; j++) {
+            u32 k = first - start + j;
+
+            weights[k] = lround(contrib[j] * (1 << WEIGHT_BITS));
+            sum += weights[k];
+
+            if (weights[k] > weights[biggest])
+                biggest = k;
+        }
+
+        weights[biggest] += (1 << WEIGHT_BITS) - sum;
+        coeffs->start[i] = start;
+    }
+}
+
+static void resample_rows(const u8 *src, u32 src_w, u16 *inter, u32 dst_w, u32 rows, const coeffs_t *coeffs) {
+    for (u32 y = 0; y < rows; y++) {
+        const u8 *row = src + y * src_w * sizeof(lv_color_t);
+        u16 *out = inter + y * dst_w * sizeof(lv_color_t);
+
+        for (u32 x = 0; x < dst_w; x++) {
+            const u8 *px = row + coeffs->start[x] * sizeof(lv_color_t);
+            const u16 *weights = &coeffs->weights[x * coeffs->taps];
+
+#ifdef __ARM_NEON
+            uint32x4_t acc = vdupq_n_u32(0);
+
+            for (u32 k = 0; k < coeffs->taps; k++) {
+                uint8x8_t bgra = vreinterpret_u8_u32(vld1_dup_u32((const u32 *) (px + k * sizeof(lv_color_t))));
+                acc = vmlal_n_u16(acc, vget_low_u16(vmovl_u8(bgra)), weights[k]);
+            }
+
+            vst1_u16(out + x * 4, vrshrn_n_u32(acc, H_SHIFT));
+#else
+            // A named sum per channel stays in registers, an array of them didn't
+            u32 b = 0;
+            u32 g = 0;
+            u32 r = 0;
+            u32 a = 0;
+
+            for (u32 k = 0; k < coeffs->taps; k++) {
+                const u8 *p = px + k * sizeof(lv_color_t);
+
+                b += p[0] * weights[k];
+                g += p[1] * weights[k];
+                r += p[2] * weights[k];
+                a += p[3] * weights[k];
+            }
+
+            out[x * 4 + 0] = (b + (1 << (H_SHIFT - 1))) >> H_SHIFT;
+            out[x * 4 + 1] = (g + (1 << (H_SHIFT - 1))) >> H_SHIFT;
+            out[x * 4 + 2] = (r + (1 << (H_SHIFT - 1))) >> H_SHIFT;
+            out[x * 4 + 3] = (a + (1 << (H_SHIFT - 1))) >> H_SHIFT;
+#endif
+        }
+    }
+}
+
+static void resample_cols(const u16 *inter, u8 *dst, u32 dst_w, u32 dst_h, const coeffs_t *coeffs) {
+    u32 stride = dst_w * sizeof(lv_color_t);
+
+    for (u32 y = 0; y < dst_h; y++) {
+        const u16 *rows = inter + coeffs->start[y] * stride;
+        const u16 *weights = &coeffs->weights[y * coeffs->taps];
+        u8 *out = dst + y * stride;
+        u32 x = 0;
+
+#ifdef __ARM_NEON
+        for (; x + 8 <= stride; x += 8) {
+            uint32x4_t acc_lo = vdupq_n_u32(0);
+            uint32x4_t acc_hi = vdupq_n_u32(0);
+
+            for (u32 k = 0; k < coeffs->taps; k++) {
+                uint16x8_t v = vld1q_u16(rows + k * stride + x);
+                acc_lo = vmlal_n_u16(acc_lo, vget_low_u16(v), weights[k]);
+                acc_hi = vmlal_n_u16(acc_hi, vget_high_u16(v), weights[k]);
+            }
+
+            uint16x8_t res = vcombine_u16(vmovn_u32(vrshrq_n_u32(acc_lo, V_SHIFT)), vmovn_u32(vrshrq_n_u32(acc_hi, V_SHIFT)));
+            vst1_u8(out + x, vqmovn_u16(res));
+        }
+#endif
+
+        // Whatever is left over is less than 8 channels, a pixel at most on NEON
+        for (; x < stride; x += sizeof(lv_color_t)) {
+            u32 b = 0;
+            u32 g = 0;
+            u32 r = 0;
+            u32 a = 0;
+
+            for (u32 k = 0; k < coeffs->taps; k++) {
+                const u16 *p = rows + k * stride + x;
+
+                b += p[0] * weights[k];
+                g += p[1] * weights[k];
+                r += p[2] * weights[k];
+                a += p[3] * weights[k];
+            }
+
+            out[x + 0] = (b + (1 << (V_SHIFT - 1))) >> V_SHIFT;
+            out[x + 1] = (g + (1 << (V_SHIFT - 1))) >> V_SHIFT;
+            out[x + 2] = (r + (1 << (V_SHIFT - 1))) >> V_SHIFT;
+            out[x + 3] = (a + (1 << (V_SHIFT - 1))) >> V_SHIFT;
+        }
+    }
+}
+
+size_t resample_scratch_size(u32 src_w, u32 src_h, u32 dst_w, u32 dst_h) {
+    // The tables and the horizontally resampled rows
+    return (dst_w + dst_h) * sizeof(u32)
+        + (dst_w * num_taps(src_w, dst_w) + dst_h * num_taps(src_h, dst_h)) * sizeof(u16)
+        + src_h * dst_w * sizeof(lv_color_t) * sizeof(u16);
+}
+
+void resample_bgra(const u8 *src, u32 src_w, u32 src_h, u8 *dst, u32 dst_w, u32 dst_h, void *scratch) {
+    if (src_w == dst_w && src_h == dst_h) {
+        memcpy(dst, src, src_w * src_h * sizeof(lv_color_t));
+        return;
+    }
+
+    coeffs_t h_coeffs = {.taps = num_taps(src_w, dst_w)};
+    coeffs_t v_coeffs = {.taps = num_taps(src_h, dst_h)};
+
+    h_coeffs.start = scratch;
+    v_coeffs.start = h_coeffs.start + dst_w;
+
+    u16 *inter = (u16 *) (v_coeffs.start + dst_h);
+    h_coeffs.weights = inter + src_h * dst_w * sizeof(lv_color_t);
+    v_coeffs.weights = h_coeffs.weights + dst_w * h_coeffs.taps;
+
+    build_coeffs(&h_coeffs, src_w, dst_w);
+    build_coeffs(&v_coeffs, src_h, dst_h);
+
+    resample_rows(src, src_w, inter, dst_w, src_h, &h_coeffs);
+    resample_cols(inter, dst, dst_w, dst_h, &v_coeffs);
+}
\ No newline at end of file
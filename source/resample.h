@@ -0,0 +1,14 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+// What resample_bgra needs for its tables and the rows in between
+size_t resample_scratch_size(u32 src_w, u32 src_h, u32 dst_w, u32 dst_h);
+
+/*
+ * Resamples a 32 bit BGRA image. Reductions use an area filter so every
+ * source pixel counts, anything else is bilinear. scratch has to hold
+ * resample_scratch_size bytes, it isn't needed if the size stays the same.
+ */
+void resample_bgra(const u8 *src, u32 src_w, u32 src_h, u8 *dst, u32 dst_w, u32 dst_h, void *scratch);
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <stdatomic.h>
+#include <lvgl/lvgl.h>
+
+#ifdef __SWITCH__
+
+#include <switch.h>
+
+#endif
+
+#include "scan_pool.h"
+
+typedef struct {
+    scan_queue_t *queue;
+
+    atomic_int next_job;
+    atomic_int next_core;
+    atomic_bool stop;
+
+    scan_work_cb_t work;
+
+    mtx_t done_mtx;
+    scan_done_cb_t done;
+    void *done_arg;
+} scan_pool_t;
+
+void scan_queue_init(scan_queue_t *queue) {
+    queue->jobs = NULL;
+    queue->len = 0;
+    queue->cap = 0;
+}
+
+void scan_queue_clear(scan_queue_t *queue) {
+    for (int i = 0; i < queue->len; i++)
+        free(queue->jobs[i].name);
+
+    free(queue->jobs);
+    scan_queue_init(queue);
+}
+
+lv_res_t scan_queue_add(scan_queue_t *queue, const char *name, bool is_dir) {
+    if (queue->len == queue->cap) {
+        int new_cap = (queue->cap == 0) ? 64 : queue->cap * 2;
+
+        scan_job_t *new_jobs = realloc(queue->jobs, new_cap * sizeof(scan_job_t));
+        if (new_jobs == NULL)
+            return LV_RES_INV;
+
+        queue->jobs = new_jobs;
+        queue->cap = new_cap;
+    }
+
+    char *name_dup = strdup(name);
+    if (name_dup == NULL)
+        return LV_RES_INV;
+
+    queue->jobs[queue->len].name = name_dup;
+    queue->jobs[queue->len].is_dir = is_dir;
+    queue->len++;
+
+    return LV_RES_OK;
+}
+
+static int scan_worker(void *arg) {
+    scan_pool_t *pool = arg;
+
+    for (;;) {
+        int i = atomic_fetch_add(&pool->next_job, 1);
+        if (i >= pool->queue->len || atomic_load(&pool->stop))
+            break;
+
+        void *result = pool->work(&pool->queue->jobs[i]);
+        if (result == NULL)
+            continue;
+
+        mtx_lock(&pool->done_mtx);
+
+        if (atomic_load(&pool->stop))
+            free(result);
+        else if (!pool->done(result, pool->done_arg))
+            atomic_store(&pool->stop, true);
+
+        mtx_unlock(&pool->done_mtx);
+    }
+
+    return 0;
+}
+
+static int scan_worker_thread(void *arg) {
+    #ifdef __SWITCH__
+
+    scan_pool_t *pool = arg;
+
+    // New threads start on the default core, spread them over the others so the parsing can overlap too
+    int core = (atomic_fetch_add(&pool->next_core, 1) + 1) % 3;
+    svcSetThreadCoreMask(CUR_THREAD_HANDLE, core, BIT(core));
+
+    #endif
+
+    return scan_worker(arg);
+}
+
+lv_res_t scan_pool_run(scan_queue_t *queue, int num_workers, scan_work_cb_t work, scan_done_cb_t done, void *arg) {
+    scan_pool_t pool = {
+        .queue = queue,
+        .work = work,
+        .done = done,
+        .done_arg = arg,
+    };
+
+    atomic_init(&pool.next_job, 0);
+    atomic_init(&pool.next_core, 0);
+    atomic_init(&pool.stop, false);
+
+    mtx_init(&pool.done_mtx, mtx_plain);
+
+    if (num_workers < 1)
+        num_workers = 1;
+    if (num_workers > SCAN_POOL_MAX_WORKERS)
+        num_workers = SCAN_POOL_MAX_WORKERS;
+
+    // The calling thread works through the queue too, so it's one less thread to start
+    thrd_t threads[SCAN_POOL_MAX_WORKERS - 1];
+    int num_threads = 0;
+
+    while (num_threads < num_workers - 1 && thrd_create(&threads[num_threads], scan_worker_thread, &pool) == thrd_success)
+        num_threads++;
+
+    scan_worker(&pool);
+
+    for (int i = 0; i < num_threads; i++)
+        thrd_join(threads[i], NULL);
+
+    mtx_destroy(&pool.done_mtx);
+
+    return atomic_load(&pool.stop) ? LV_RES_INV : LV_RES_OK;
+}
\ No newline at end of file
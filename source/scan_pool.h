@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <lvgl/lvgl.h>
+
+#define SCAN_POOL_MAX_WORKERS 4
+
+typedef struct {
+    char *name;
+    bool is_dir;
+} scan_job_t;
+
+// Listed up front, listing is cheap next to what the workers do with each entry
+typedef struct {
+    scan_job_t *jobs;
+    int len;
+    int cap;
+} scan_queue_t;
+
+void scan_queue_init(scan_queue_t *queue);
+void scan_queue_clear(scan_queue_t *queue);
+
+lv_res_t scan_queue_add(scan_queue_t *queue, const char *name, bool is_dir);
+
+// Turns a job into a malloc'd result, or NULL if there's nothing there
+typedef void *(*scan_work_cb_t)(const scan_job_t *job);
+
+// Takes ownership of a result and returns false to stop the scan early
+typedef bool (*scan_done_cb_t)(void *result, void *arg);
+
+/*
+ * Works through the queue on num_workers threads, the calling one included,
+ * from 1 up to SCAN_POOL_MAX_WORKERS. done is called from whichever worker
+ * has a result, but never concurrently. Returns LV_RES_INV if it was stopped.
+ */
+lv_res_t scan_pool_run(scan_queue_t *queue, int num_workers, scan_work_cb_t work, scan_done_cb_t done, void *arg);
\ No newline at end of file
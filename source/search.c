@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "search.h"
+#include "apps.h"
+#include "catalog.h"
+
+typedef struct {
+    char buf[SEARCH_QUERY_LEN];
+    const char *terms[SEARCH_MAX_TERMS];
+    size_t lens[SEARCH_MAX_TERMS];
+    int num;
+} search_terms_t;
+
+static inline bool is_word_start(const char *str, size_t pos) {
+    if (!isalnum((unsigned char) str[pos]))
+        return false;
+
+    if (pos == 0 || !isalnum((unsigned char) str[pos - 1]))
+        return true;
+
+    // Catches the words in names like "RetroArch"
+    return isupper((unsigned char) str[pos]) && islower((unsigned char) str[pos - 1]);
+}
+
+static u64 pack_key(const char *str, size_t len) {
+    u64 key = 0;
+
+    for (size_t i = 0; i < 8 && i < len && str[i] != '\0'; i++)
+        key |= (u64) (u8) tolower((unsigned char) str[i]) << (56 - 8 * i);
+
+    return key;
+}
+
+static int prefix_cmp(const void *a, const void *b) {
+    u64 key_a = ((const search_prefix_t *) a)->key;
+    u64 key_b = ((const search_prefix_t *) b)->key;
+
+    return (key_a > key_b) - (key_a < key_b);
+}
+
+// Same order as the catalog, with the pointer breaking ties so duplicates end up next to each other
+static int result_cmp(const void *a, const void *b) {
+    app_entry_t *entry_a = *(app_entry_t * const *) a;
+    app_entry_t *entry_b = *(app_entry_t * const *) b;
+
+    int res = app_entry_cmp(entry_a, entry_b);
+    if (res != 0)
+        return res;
+
+    return (entry_a > entry_b) - (entry_a < entry_b);
+}
+
+static bool str_has_word_prefix(const char *str, const char *term, size_t len) {
+    for (size_t i = 0; str[i] != '\0'; i++) {
+        if (is_word_start(str, i) && strncasecmp(str + i, term, len) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static bool entry_matches(app_entry_t *entry, search_terms_t *terms) {
+    for (int i = 0; i < terms->num; i++) {
+        if (!str_has_word_prefix(entry->name, terms->terms[i], terms->lens[i]) && !str_has_word_prefix(entry->author, terms->terms[i], terms->lens[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static void split_terms(const char *query, search_terms_t *terms) {
+    strncpy(terms->buf, query, SEARCH_QUERY_LEN - 1);
+    terms->buf[SEARCH_QUERY_LEN - 1] = '\0';
+
+    terms->num = 0;
+
+    char *p = terms->buf;
+    while (*p != '\0' && terms->num < SEARCH_MAX_TERMS) {
+        while (*p == ' ')
+            p++;
+
+        if (*p == '\0')
+            break;
+
+        terms->terms[terms->num] = p;
+
+        while (*p != '\0' && *p != ' ') {
+            *p = tolower((unsigned char) *p);
+            p++;
+        }
+
+        terms->lens[terms->num] = p - terms->terms[terms->num];
+        terms->num++;
+    }
+}
+
+static lv_res_t add_prefixes(search_t *search, app_entry_t *entry, const char *str) {
+    for (size_t i = 0; str[i] != '\0'; i++) {
+        if (!is_word_start(str, i))
+            continue;
+
+        if (search->num_prefixes == search->prefixes_cap) {
+            int new_cap = (search->prefixes_cap == 0) ? 256 : search->prefixes_cap * 2;
+
+            search_prefix_t *new_prefixes = realloc(search->prefixes, new_cap * sizeof(search_prefix_t));
+            if (new_prefixes == NULL)
+                return LV_RES_INV;
+
+            search->prefixes = new_prefixes;
+            search->prefixes_cap = new_cap;
+        }
+
+        search->prefixes[search->num_prefixes].key = pack_key(str + i, 8);
+        search->prefixes[search->num_prefixes].entry = entry;
+        search->num_prefixes++;
+    }
+
+    return LV_RES_OK;
+}
+
+static lv_res_t reserve_results(search_t *search, int cap) {
+    if (cap <= search->results_cap)
+        return LV_RES_OK;
+
+    app_entry_t **new_results = realloc(search->results, cap * sizeof(app_entry_t *));
+    if (new_results == NULL)
+        return LV_RES_INV;
+
+    search->results = new_results;
+    search->results_cap = cap;
+
+    return LV_RES_OK;
+}
+
+// Looks the first term up in the prefix table and checks every term on what it finds
+static lv_res_t run_query(search_t *search, search_terms_t *terms) {
+    size_t len = terms->lens[0];
+    u64 key = pack_key(terms->terms[0], len);
+    u64 mask = (len >= 8) ? ~0ull : ~(~0ull >> (8 * len));
+
+    int lo = 0;
+    int hi = search->num_prefixes;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (search->prefixes[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    int end = lo;
+    while (end < search->num_prefixes && (search->prefixes[end].key & mask) == key)
+        end++;
+
+    if (reserve_results(search, end - lo) != LV_RES_OK)
+        return LV_RES_INV;
+
+    search->num_results = 0;
+
+    for (int i = lo; i < end; i++) {
+        app_entry_t *entry = search->prefixes[i].entry;
+
+        if (entry_matches(entry, terms))
+            search->results[search->num_results++] = entry;
+    }
+
+    qsort(search->results, search->num_results, sizeof(app_entry_t *), result_cmp);
+
+    // An entry with several matching words shows up once per word
+    int num_unique = 0;
+    for (int i = 0; i < search->num_results; i++) {
+        if (num_unique == 0 || search->results[num_unique - 1] != search->results[i])
+            search->results[num_unique++] = search->results[i];
+    }
+
+    search->num_results = num_unique;
+
+    return LV_RES_OK;
+}
+
+void search_init(search_t *search) {
+    search->prefixes = NULL;
+    search->num_prefixes = 0;
+    search->prefixes_cap = 0;
+
+    search->results = NULL;
+    search->num_results = 0;
+    search->results_cap = 0;
+
+    search->query[0] = '\0';
+}
+
+void search_clear(search_t *search) {
+    free(search->prefixes);
+    free(search->results);
+
+    search_init(search);
+}
+
+lv_res_t search_build(search_t *search, catalog_t *catalog) {
+    search->num_prefixes = 0;
+    search->num_results = 0;
+
+    for (int i = 0; i < catalog->len; i++) {
+        app_entry_t *entry = catalog->entries[i];
+
+        if (add_prefixes(search, entry, entry->name) != LV_RES_OK || add_prefixes(search, entry, entry->author) != LV_RES_OK)
+            return LV_RES_INV;
+    }
+
+    qsort(search->prefixes, search->num_prefixes, sizeof(search_prefix_t), prefix_cmp);
+
+    if (!search_active(search))
+        return LV_RES_OK;
+
+    search_terms_t terms;
+    split_terms(search->query, &terms);
+
+    return run_query(search, &terms);
+}
+
+lv_res_t search_query(search_t *search, const char *query) {
+    search_terms_t terms;
+    split_terms(query, &terms);
+
+    if (terms.num == 0) {
+        search->query[0] = '\0';
+        search->num_results = 0;
+
+        return LV_RES_OK;
+    }
+
+    // Typing on only ever narrows things down, so there's no need to go back to the table
+    bool narrowing = search_active(search) && strncmp(query, search->query, strlen(search->query)) == 0;
+
+    strncpy(search->query, query, SEARCH_QUERY_LEN - 1);
+    search->query[SEARCH_QUERY_LEN - 1] = '\0';
+
+    if (!narrowing)
+        return run_query(search, &terms);
+
+    int num_kept = 0;
+    for (int i = 0; i < search->num_results; i++) {
+        if (entry_matches(search->results[i], &terms))
+            search->results[num_kept++] = search->results[i];
+    }
+
+    search->num_results = num_kept;
+
+    return LV_RES_OK;
+}
+
+bool search_active(search_t *search) {
+    return search->query[0] != '\0';
+}
\ No newline at end of file
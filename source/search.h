@@ -0,0 +1,43 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "apps.h"
+#include "catalog.h"
+
+#define SEARCH_QUERY_LEN 64
+#define SEARCH_MAX_TERMS 8
+
+typedef struct {
+    u64 key; // Up to 8 lowercased bytes from the start of a word, first byte on top
+    app_entry_t *entry;
+} search_prefix_t;
+
+/*
+ * Finds apps where every term of the query starts a word of their name or
+ * author. Every word start is put in one sorted table, so a query is a
+ * binary search for its first term plus a check of the entries it lands on.
+ * A query that only extends the last one just narrows the last results.
+ */
+typedef struct {
+    search_prefix_t *prefixes;
+    int num_prefixes;
+    int prefixes_cap;
+
+    app_entry_t **results; // In catalog order
+    int num_results;
+    int results_cap;
+
+    char query[SEARCH_QUERY_LEN];
+} search_t;
+
+void search_init(search_t *search);
+void search_clear(search_t *search);
+
+// Has to be redone whenever entries are added to or removed from the catalog, the current query is run again
+lv_res_t search_build(search_t *search, catalog_t *catalog);
+
+// A query without any terms turns the filter off
+lv_res_t search_query(search_t *search, const char *query);
+bool search_active(search_t *search);
\ No newline at end of file
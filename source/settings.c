@@ -4,6 +4,7 @@
 #include <switch.h>
 #include <lvgl/lvgl.h>
 
+#include "scan_pool.h"
 #include "settings.h"
 #include "util.h"
 
@@ -23,6 +24,9 @@ static settings_t g_default_settings = {
     .remote_type = RemoteLoaderType_net,
 
     .lang_id = SetLanguage_ENUS,
+
+    .scan_threads = 3,
+    .icon_cache_kb = 8192,
 };
 
 static settings_t g_curr_settings;
@@ -79,6 +83,21 @@ lv_res_t settings_init() {
             tmp_int = g_default_settings.remote_type;
         g_curr_settings.remote_type = tmp_int;
 
+        if (config_setting_lookup_int(settings, "scan_threads", &tmp_int) != CONFIG_TRUE)
+            tmp_int = g_default_settings.scan_threads;
+        if (tmp_int < 1)
+            tmp_int = 1;
+        if (tmp_int > SCAN_POOL_MAX_WORKERS)
+            tmp_int = SCAN_POOL_MAX_WORKERS;
+        g_curr_settings.scan_threads = tmp_int;
+
+        if (config_setting_lookup_int(settings, "icon_cache_kb", &tmp_int) != CONFIG_TRUE)
+            tmp_int = g_default_settings.icon_cache_kb;
+        if (tmp_int < 0)
+            tmp_int = 0;
+        if (tmp_int > SETTINGS_ICON_CACHE_MAX_KB)
+            tmp_int = SETTINGS_ICON_CACHE_MAX_KB;
+        g_curr_settings.icon_cache_kb = tmp_int;
 
         if (config_setting_lookup_string(settings, "language", &tmp_str) == CONFIG_TRUE)
             lang_code = str_to_lang_code(tmp_str);
@@ -5,6 +5,9 @@
 
 #define SETTINGS_DIR "sdmc:/config/nx-hbc"
 
+// Well short of what an applet gets, 0 turns the cache off
+#define SETTINGS_ICON_CACHE_MAX_KB (256 * 1024)
+
 typedef enum {
     RemoteLoaderType_disabled,
     RemoteLoaderType_net,
@@ -24,6 +27,8 @@ typedef struct {
     RemoteLoaderType remote_type;
 
     u8 lang_id;
+    u8 scan_threads;
+    u32 icon_cache_kb;
 } settings_t;
 
 lv_res_t settings_init();
@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "str_arena.h"
+#include "util.h"
+
+#define CHUNK_SIZE 0x4000
+
+struct str_arena_chunk {
+    struct str_arena_chunk *next;
+    size_t used;
+    size_t cap;
+    char data[];
+};
+
+static char *arena_alloc(str_arena_t *arena, size_t size) {
+    str_arena_chunk_t *chunk = arena->chunks;
+
+    if (chunk == NULL || chunk->cap - chunk->used < size) {
+        size_t cap = (size > CHUNK_SIZE) ? size : CHUNK_SIZE;
+
+        chunk = malloc(sizeof(str_arena_chunk_t) + cap);
+        if (chunk == NULL)
+            return NULL;
+
+        chunk->next = arena->chunks;
+        chunk->used = 0;
+        chunk->cap = cap;
+
+        arena->chunks = chunk;
+    }
+
+    char *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->bytes_used += size;
+
+    return ptr;
+}
+
+void str_arena_init(str_arena_t *arena) {
+    mtx_init(&arena->mtx, mtx_plain);
+
+    arena->chunks = NULL;
+    arena->slots = NULL;
+    arena->slots_cap = 0;
+    arena->slots_len = 0;
+    arena->bytes_used = 0;
+}
+
+void str_arena_exit(str_arena_t *arena) {
+    while (arena->chunks != NULL) {
+        str_arena_chunk_t *next = arena->chunks->next;
+        free(arena->chunks);
+        arena->chunks = next;
+    }
+
+    free(arena->slots);
+
+    arena->slots = NULL;
+    arena->slots_cap = 0;
+    arena->slots_len = 0;
+    arena->bytes_used = 0;
+
+    mtx_destroy(&arena->mtx);
+}
+
+const char *str_arena_intern(str_arena_t *arena, const char *str, size_t len) {
+    mtx_lock(&arena->mtx);
+
+    const char **slots = hash_grow(arena->slots, sizeof(const char *), &arena->slots_cap, &arena->slots_len, 512, NULL);
+    if (slots == NULL) {
+        mtx_unlock(&arena->mtx);
+        return NULL;
+    }
+
+    arena->slots = slots;
+
+    const char **slot = hash_find_slot(arena->slots, sizeof(const char *), arena->slots_cap, str, len, NULL);
+
+    if (*slot == NULL) {
+        char *copy = arena_alloc(arena, len + 1);
+        if (copy == NULL) {
+            mtx_unlock(&arena->mtx);
+            return NULL;
+        }
+
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+
+        *slot = copy;
+        arena->slots_len++;
+    }
+
+    const char *ret = *slot;
+
+    mtx_unlock(&arena->mtx);
+
+    return ret;
+}
\ No newline at end of file
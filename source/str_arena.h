@@ -0,0 +1,28 @@
+#pragma once
+
+#include <threads.h>
+#include <lvgl/lvgl.h>
+
+typedef struct str_arena_chunk str_arena_chunk_t;
+
+/*
+ * Append-only string storage with interning, so equal strings share one
+ * copy. Strings stay put until str_arena_exit, and interning is
+ * safe to do from multiple threads.
+ */
+typedef struct {
+    mtx_t mtx;
+
+    str_arena_chunk_t *chunks;
+
+    const char **slots;
+    size_t slots_cap;
+    size_t slots_len;
+
+    size_t bytes_used;
+} str_arena_t;
+
+void str_arena_init(str_arena_t *arena);
+void str_arena_exit(str_arena_t *arena);
+
+const char *str_arena_intern(str_arena_t *arena, const char *str, size_t len);
\ No newline at end of file
@@ -88,6 +88,14 @@ static const char *g_strings[StrId_max][SetLanguage_Total] = {
     [StrId_unstar] = {
         STR_EN("Unstar"),
     },
+
+    [StrId_search] = {
+        STR_EN("Search: %s"),
+    },
+
+    [StrId_space] = {
+        STR_EN("Space"),
+    },
 };
 
 const char *text_get(StrId id) {
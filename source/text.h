@@ -32,6 +32,8 @@ typedef enum {
     StrId_star,
     StrId_back,
     StrId_unstar,
+    StrId_search,
+    StrId_space,
 
     StrId_max
 } StrId;
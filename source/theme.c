@@ -17,15 +17,21 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
-#include <minizip/unzip.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <libconfig.h>
 #include <threads.h>
 #include <lvgl/lvgl.h>
 #include <switch.h>
 
 #include "theme.h"
+#include "decoder.h"
 #include "settings.h"
 #include "log.h"
+#include "theme_pack.h"
+#include "zip_reader.h"
+#include "util.h"
 
 #ifdef MUSIC
 
@@ -33,10 +39,13 @@
 
 #endif
 
-#define DEFAULT_THEME_PATH "romfs:/theme.zip"
+#define DEFAULT_THEME_PACK_PATH "romfs:/theme.hbctheme"
 
 #define GEN_ASSET(x) {.file_name = x}
 
+// Below this much free LVGL heap, lazy assets nothing is showing get freed
+#define LAZY_EVICT_FREE_SIZE (16 * 1024 * 1024)
+
 typedef enum {
     AssetId_background,
     AssetId_cursor,
@@ -95,6 +104,30 @@ static asset_t g_assets_list[AssetId_max] = {
 
 static theme_t g_curr_theme;
 
+typedef struct {
+    AssetId id;
+    ThemeLazy group;
+    lv_img_dsc_t *dsc;
+    u32 w;
+    u32 h;
+} lazy_asset_t;
+
+static const lazy_asset_t g_lazy_assets[] = {
+    {AssetId_dialog_background, ThemeLazy_dialog, &g_curr_theme.dialog_bg_dsc, DIALOG_BG_W, DIALOG_BG_H},
+    {AssetId_button_tiny, ThemeLazy_dialog, &g_curr_theme.dialog_btns_dscs[0], DIALOG_BTN_W, DIALOG_BTN_H},
+    {AssetId_button_tiny_focus, ThemeLazy_dialog, &g_curr_theme.dialog_btns_dscs[1], DIALOG_BTN_W, DIALOG_BTN_H},
+    {AssetId_remote_progress, ThemeLazy_remote, &g_curr_theme.remote_progress_dsc, REMOTE_PROGRESS_W, REMOTE_PROGRESS_H},
+    {AssetId_cursor, ThemeLazy_cursor, &g_curr_theme.cursor_dsc, CURSOR_W, CURSOR_H},
+};
+
+#define NUM_LAZY_ASSETS (sizeof(g_lazy_assets) / sizeof(g_lazy_assets[0]))
+
+static const char *g_lazy_names[ThemeLazy_max] = {"dialog", "remote", "cursor"};
+
+// In use outlives a theme reset, so whatever's on screen gets loaded again from the new theme
+static bool g_lazy_loaded[ThemeLazy_max];
+static bool g_lazy_in_use[ThemeLazy_max];
+
 static lv_task_t *g_reset_task = NULL;
 static bool g_should_reset = false;
 static mtx_t g_reset_mtx;
@@ -117,35 +150,106 @@ static int config_setting_lookup_color(config_setting_t *setting, const char *na
     return ret;
 }
 
-static int asset_load(asset_t *asset, unzFile zf) {
-    int ret = unzLocateFile(zf, asset->file_name, 0);
-    if (ret != UNZ_OK)
-        return ret;
+// What the loaded image assets take up in memory by encoding, against what they'd take fully expanded
+typedef struct {
+    size_t raw;
+    size_t indexed;
+    size_t rle;
+    size_t expanded;
+} asset_mem_stats_t;
+
+static asset_mem_stats_t g_asset_mem;
+
+// Themes come as a pack or a zip, anything that couldn't be opened just has no files
+typedef struct {
+    bool is_pack;
+    theme_pack_t pack;
+    zip_reader_t zip;
+} theme_src_t;
+
+// Kept open as long as the theme is, lazy assets get read from them on first use
+static theme_src_t g_src_default;
+static theme_src_t g_src;
+
+// Where theme_install copies to, theme.zip itself is still open until the reset
+#define THEME_NEW_PATH THEME_PATH ".new"
+
+static void theme_src_open(theme_src_t *src, const char *path, bool is_pack) {
+    src->is_pack = is_pack;
+
+    if (is_pack)
+        theme_pack_open(&src->pack, path);
+    else
+        zip_reader_open(&src->zip, path, true);
+}
 
-    ret = unzOpenCurrentFile(zf);
-    if (ret != UNZ_OK)
-        return ret;
+static void theme_src_close(theme_src_t *src) {
+    if (src->is_pack)
+        theme_pack_close(&src->pack);
+    else
+        zip_reader_close(&src->zip);
+}
 
-    unz_file_info file_info;
-    ret = unzGetCurrentFileInfo(zf, &file_info, NULL, 0, NULL, 0, NULL, 0);
-    if (ret != UNZ_OK) {
-        unzCloseCurrentFile(zf);
-        return ret;
+// Returns the pack record or zip member to pass to theme_src_read, NULL if there's no such file
+static const void *theme_src_find(theme_src_t *src, const char *name, size_t *size, lv_img_cf_t *cf) {
+    if (src->is_pack) {
+        const theme_pack_rec_t *rec = theme_pack_find(&src->pack, name);
+        if (rec != NULL) {
+            *size = rec->size;
+            *cf = rec->format;
+        }
+
+        return rec;
     }
 
-    asset->size = file_info.uncompressed_size;
+    // Images in zips are always plain BGRA
+    const zip_member_t *member = zip_reader_find(&src->zip, name);
+    if (member != NULL) {
+        *size = member->size;
+        *cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    }
+
+    return member;
+}
+
+static lv_res_t theme_src_read(theme_src_t *src, const void *file, void *buf) {
+    if (src->is_pack)
+        return theme_pack_read(&src->pack, file, buf);
+
+    return zip_reader_read(&src->zip, file, buf);
+}
+
+static lv_res_t asset_load(asset_t *asset, theme_src_t *src) {
+    const void *file = theme_src_find(src, asset->file_name, &asset->size, &asset->cf);
+    if (file == NULL)
+        return LV_RES_INV;
 
     asset->buffer = lv_mem_alloc(asset->size);
-    ret = unzReadCurrentFile(zf, asset->buffer, asset->size);
-    if (ret < asset->size) {
+    if (asset->buffer == NULL)
+        return LV_RES_INV;
+
+    if (theme_src_read(src, file, asset->buffer) != LV_RES_OK) {
         lv_mem_free(asset->buffer);
-        unzCloseCurrentFile(zf);
-        return -12;
+        asset->buffer = NULL;
+        return LV_RES_INV;
     }
 
-    unzCloseCurrentFile(zf);
+    return LV_RES_OK;
+}
 
-    return UNZ_OK;
+// The installed theme first, anything it lacks comes from the default one
+static lv_res_t asset_load_any(asset_t *asset) {
+    if (asset_load(asset, &g_src) == LV_RES_OK)
+        return LV_RES_OK;
+
+    return asset_load(asset, &g_src_default);
+}
+
+static bool asset_exists(asset_t *asset) {
+    size_t size;
+    lv_img_cf_t cf;
+
+    return theme_src_find(&g_src, asset->file_name, &size, &cf) != NULL || theme_src_find(&g_src_default, asset->file_name, &size, &cf) != NULL;
 }
 
 static void asset_clean(asset_t *asset) {
@@ -161,10 +265,35 @@ static void asset_to_img_dsc(lv_img_dsc_t *dsc, asset_t *assets, AssetId id, u32
     dsc->header.w = width;
     dsc->header.h = height;
     dsc->data_size = asset->size;
-    dsc->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    dsc->header.cf = (asset->cf != LV_IMG_CF_UNKNOWN) ? asset->cf : LV_IMG_CF_TRUE_COLOR_ALPHA;
     dsc->data = asset->buffer;
 }
 
+// Palette images go to LVGL's own decoder and run length encoded ones to ours, both a line at a time
+static size_t *asset_mem_bucket(const lv_img_dsc_t *dsc) {
+    if (dsc->header.cf >= LV_IMG_CF_INDEXED_1BIT && dsc->header.cf <= LV_IMG_CF_INDEXED_8BIT)
+        return &g_asset_mem.indexed;
+
+    if (dsc->header.cf == LV_IMG_CF_RAW_ALPHA)
+        return &g_asset_mem.rle;
+
+    return &g_asset_mem.raw;
+}
+
+static void asset_mem_add(const lv_img_dsc_t *dsc) {
+    *asset_mem_bucket(dsc) += dsc->data_size;
+    g_asset_mem.expanded += dsc->header.w * dsc->header.h * sizeof(lv_color_t);
+}
+
+static void asset_mem_sub(const lv_img_dsc_t *dsc) {
+    *asset_mem_bucket(dsc) -= dsc->data_size;
+    g_asset_mem.expanded -= dsc->header.w * dsc->header.h * sizeof(lv_color_t);
+}
+
+static void asset_mem_log(const char *what) {
+    logPrintf("theme assets %s: %zu raw, %zu indexed, %zu rle bytes, %zu expanded\n", what, g_asset_mem.raw, g_asset_mem.indexed, g_asset_mem.rle, g_asset_mem.expanded);
+}
+
 static void theme_load_assets(theme_t *theme, asset_t *assets) {
     asset_to_img_dsc(&theme->background_dsc, assets, AssetId_background, LV_HOR_RES_MAX, LV_VER_RES_MAX);
 
@@ -174,11 +303,6 @@ static void theme_load_assets(theme_t *theme, asset_t *assets) {
     for (int i = 0; i < 2; i++)
         asset_to_img_dsc(&theme->list_btns_dscs[i], assets, AssetId_apps_list + i, LIST_BTN_W, LIST_BTN_H);
 
-    asset_to_img_dsc(&theme->dialog_bg_dsc, assets, AssetId_dialog_background, DIALOG_BG_W, DIALOG_BG_H);
-
-    for (int i = 0; i < 2; i++)
-        asset_to_img_dsc(&theme->dialog_btns_dscs[i], assets, AssetId_button_tiny + i, DIALOG_BTN_W, DIALOG_BTN_H);
-
     for (int i = 0; i < 4; i++)
         asset_to_img_dsc(&theme->arrow_btns_dscs[i], assets, AssetId_apps_next + i, ARROW_BTN_W, ARROW_BTN_H);
 
@@ -187,9 +311,107 @@ static void theme_load_assets(theme_t *theme, asset_t *assets) {
     for (int i = 0; i < 2; i++)
         asset_to_img_dsc(&theme->net_icons_dscs[i], assets, AssetId_network_inactive + i, NET_ICON_W, NET_ICON_H);
 
-    asset_to_img_dsc(&theme->remote_progress_dsc, assets, AssetId_remote_progress, REMOTE_PROGRESS_W, REMOTE_PROGRESS_H);
+    g_asset_mem = (asset_mem_stats_t) {0};
+
+    asset_mem_add(&theme->background_dsc);
+
+    for (int i = 0; i < 2; i++) {
+        asset_mem_add(&theme->star_dscs[i]);
+        asset_mem_add(&theme->list_btns_dscs[i]);
+        asset_mem_add(&theme->net_icons_dscs[i]);
+    }
+
+    for (int i = 0; i < 4; i++)
+        asset_mem_add(&theme->arrow_btns_dscs[i]);
+
+    asset_mem_add(&theme->logo_dsc);
+
+    asset_mem_log("loaded");
+}
+
+// Lazy assets, and the music when there's no BGM, aren't read by theme_init
+static bool is_deferred(AssetId id) {
+    for (size_t i = 0; i < NUM_LAZY_ASSETS; i++) {
+        if (g_lazy_assets[i].id == id)
+            return true;
+    }
+
+    #ifdef MUSIC
+
+    if ((id == AssetId_intro_music || id == AssetId_loop_music) && !curr_settings()->play_bgm)
+        return true;
+
+    #endif
+
+    return false;
+}
+
+// Also undoes a lazy_load that failed part way, its untouched descriptors are all zero
+static void lazy_evict(ThemeLazy group) {
+    for (size_t i = 0; i < NUM_LAZY_ASSETS; i++) {
+        const lazy_asset_t *lazy = &g_lazy_assets[i];
+        if (lazy->group != group)
+            continue;
+
+        // LVGL and the decoder cache may still know the descriptor
+        decoderCacheDrop(lazy->dsc);
+        asset_mem_sub(lazy->dsc);
+
+        asset_clean(&g_assets_list[lazy->id]);
+        memset(lazy->dsc, 0, sizeof(lv_img_dsc_t));
+    }
+
+    if (g_lazy_loaded[group]) {
+        char what[32];
+        snprintf(what, sizeof(what), "after %s evicted", g_lazy_names[group]);
+        asset_mem_log(what);
+    }
+
+    g_lazy_loaded[group] = false;
+}
+
+static void lazy_evict_unused() {
+    for (int i = 0; i < ThemeLazy_max; i++) {
+        if (g_lazy_loaded[i] && !g_lazy_in_use[i])
+            lazy_evict(i);
+    }
+}
+
+static lv_res_t lazy_load(ThemeLazy group) {
+    u64 start_tick = armGetSystemTick();
+
+    for (size_t i = 0; i < NUM_LAZY_ASSETS; i++) {
+        const lazy_asset_t *lazy = &g_lazy_assets[i];
+        if (lazy->group != group)
+            continue;
+
+        asset_t *asset = &g_assets_list[lazy->id];
+
+        // Most likely the heap is full, so make room with whatever isn't showing and try once more
+        lv_res_t res = asset_load_any(asset);
+        if (res != LV_RES_OK) {
+            lazy_evict_unused();
+            res = asset_load_any(asset);
+        }
 
-    asset_to_img_dsc(&theme->cursor_dsc, assets, AssetId_cursor, CURSOR_W, CURSOR_H);
+        if (res != LV_RES_OK) {
+            lazy_evict(group);
+            return LV_RES_INV;
+        }
+
+        asset_to_img_dsc(lazy->dsc, g_assets_list, lazy->id, lazy->w, lazy->h);
+        asset_mem_add(lazy->dsc);
+    }
+
+    g_lazy_loaded[group] = true;
+
+    logPrintf("theme %s assets loaded in %lluus\n", g_lazy_names[group], armTicksToNs(armGetSystemTick() - start_tick) / 1000);
+
+    char what[32];
+    snprintf(what, sizeof(what), "with %s", g_lazy_names[group]);
+    asset_mem_log(what);
+
+    return LV_RES_OK;
 }
 
 static void theme_init_styles(theme_t *theme) {
@@ -227,33 +449,33 @@ static void theme_init_styles(theme_t *theme) {
     theme->normal_48_style.text.font = &lv_font_roboto_48;
 
     lv_style_copy(&theme->warn_48_style, &theme->normal_48_style);
-}
 
-static lv_res_t theme_load_styles(theme_t *theme, unzFile zf) {
-    if (zf == NULL)
-        return LV_RES_INV;
+    lv_style_copy(&theme->icon_placeholder_style, &theme->dark_opa_64_style);
+    theme->icon_placeholder_style.body.radius = 8;
 
-    if (unzLocateFile(zf, "styles.cfg", 0) != UNZ_OK)
-        return LV_RES_INV;
+    lv_style_copy(&theme->search_kb_bg_style, &theme->no_apps_mbox_style);
+    theme->search_kb_bg_style.body.opa = LV_OPA_90;
+    theme->search_kb_bg_style.text.font = &lv_font_roboto_28;
 
-    if (unzOpenCurrentFile(zf) != UNZ_OK)
-        return LV_RES_INV;
+    lv_style_copy(&theme->search_kb_btn_rel_style, &lv_style_btn_rel);
+    theme->search_kb_btn_rel_style.text.font = &lv_font_roboto_28;
 
-    unz_file_info file_info;
-    if (unzGetCurrentFileInfo(zf, &file_info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) {
-        unzCloseCurrentFile(zf);
-        return LV_RES_INV;
-    }
+    lv_style_copy(&theme->search_kb_btn_pr_style, &lv_style_btn_pr);
+    theme->search_kb_btn_pr_style.text.font = &lv_font_roboto_28;
+}
 
-    char cfg_str[file_info.uncompressed_size + 1];
-    if (unzReadCurrentFile(zf, cfg_str, file_info.uncompressed_size) < file_info.uncompressed_size) {
-        unzCloseCurrentFile(zf);
+static lv_res_t theme_load_styles(theme_t *theme, theme_src_t *src) {
+    size_t size;
+    lv_img_cf_t cf;
+    const void *file = theme_src_find(src, "styles.cfg", &size, &cf);
+    if (file == NULL)
         return LV_RES_INV;
-    }
 
-    unzCloseCurrentFile(zf);
+    char cfg_str[size + 1];
+    if (theme_src_read(src, file, cfg_str) != LV_RES_OK)
+        return LV_RES_INV;
 
-    cfg_str[file_info.uncompressed_size] = '\0';
+    cfg_str[size] = '\0';
 
     config_t cfg;
 
@@ -290,6 +512,8 @@ static lv_res_t theme_load_styles(theme_t *theme, unzFile zf) {
     if (config_setting_lookup_color(styles, "dark_cover_color", &tmp_col) == CONFIG_TRUE) {
         theme->dark_opa_64_style.body.main_color = tmp_col;
         theme->dark_opa_64_style.body.grad_color = tmp_col;
+        theme->icon_placeholder_style.body.main_color = tmp_col;
+        theme->icon_placeholder_style.body.grad_color = tmp_col;
     }
 
     if (config_setting_lookup_color(styles, "status_text_color", &tmp_col) == CONFIG_TRUE) {
@@ -315,6 +539,9 @@ static lv_res_t theme_load_styles(theme_t *theme, unzFile zf) {
 }
 
 static lv_res_t theme_reset() {
+    // Every asset descriptor is about to point at a new image
+    decoderCacheClear();
+
     theme_exit();
 
     lv_res_t res = theme_init();
@@ -342,34 +569,38 @@ lv_res_t theme_init() {
     if (R_FAILED(romfsInit()))
         return LV_RES_INV;
 
-    unzFile zf_default = unzOpen(DEFAULT_THEME_PATH);
-    unzFile zf = unzOpen(THEME_PATH);
+    u64 start_tick = armGetSystemTick();
+
+    // Nothing has theme.zip open here, so an installed theme can take its place
+    struct stat st;
+    if (stat(THEME_NEW_PATH, &st) == 0)
+        replace_file(THEME_NEW_PATH, THEME_PATH);
+
+    // The built-in theme is always a pack, installed ones are always zips
+    theme_src_open(&g_src_default, DEFAULT_THEME_PACK_PATH, true);
+    theme_src_open(&g_src, THEME_PATH, false);
 
     int i_bad;
-    int ret;
+    lv_res_t res;
     for (int i = 0; i < AssetId_max; i++) {
         i_bad = i;
-        ret = -1;
 
-        if (zf != NULL)
-            ret = asset_load(&g_assets_list[i], zf);
+        // Deferred ones only have to be there, so a broken theme still fails here
+        if (is_deferred(i))
+            res = asset_exists(&g_assets_list[i]) ? LV_RES_OK : LV_RES_INV;
+        else
+            res = asset_load_any(&g_assets_list[i]);
 
-        if (ret != UNZ_OK && zf_default != NULL)
-            ret = asset_load(&g_assets_list[i], zf_default);
-
-        if (ret != UNZ_OK)
+        if (res != LV_RES_OK)
             break;
     }
 
-    if (ret != UNZ_OK) {
+    if (res != LV_RES_OK) {
         for (int i = 0; i < i_bad; i++)
             asset_clean(&g_assets_list[i]);
 
-        if (zf != NULL)
-            unzClose(zf);
-
-        if (zf_default != NULL)
-            unzClose(zf_default);
+        theme_src_close(&g_src);
+        theme_src_close(&g_src_default);
 
         romfsExit();
 
@@ -377,19 +608,18 @@ lv_res_t theme_init() {
     }
 
     theme_init_styles(&g_curr_theme);
-    theme_load_styles(&g_curr_theme, zf_default);
-    theme_load_styles(&g_curr_theme, zf);
+    theme_load_styles(&g_curr_theme, &g_src_default);
+    theme_load_styles(&g_curr_theme, &g_src);
 
-    if (zf != NULL)
-        unzClose(zf);
-
-    if (zf_default != NULL)
-        unzClose(zf_default);
-
-    romfsExit();
+    logPrintf("theme loaded in %lluus\n", armTicksToNs(armGetSystemTick() - start_tick) / 1000);
 
     theme_load_assets(&g_curr_theme, g_assets_list);
 
+    for (int i = 0; i < ThemeLazy_max; i++) {
+        if (g_lazy_in_use[i])
+            lazy_load(i);
+    }
+
     #ifdef MUSIC
 
     if (curr_settings()->play_bgm) {
@@ -415,6 +645,17 @@ void theme_exit() {
     for (int i = 0; i < AssetId_max; i++)
         asset_clean(&g_assets_list[i]);
 
+    for (size_t i = 0; i < NUM_LAZY_ASSETS; i++)
+        memset(g_lazy_assets[i].dsc, 0, sizeof(lv_img_dsc_t));
+
+    for (int i = 0; i < ThemeLazy_max; i++)
+        g_lazy_loaded[i] = false;
+
+    theme_src_close(&g_src);
+    theme_src_close(&g_src_default);
+
+    romfsExit();
+
     #ifdef MUSIC
 
     if (curr_settings()->play_bgm) {
@@ -425,12 +666,39 @@ void theme_exit() {
     #endif
 }
 
-void do_theme_reset() {
+lv_res_t theme_install(const char *path) {
     mtx_lock(&g_reset_mtx);
-    g_should_reset = true;
+
+    lv_res_t res = copy(THEME_NEW_PATH, (char *) path);
+    if (res == LV_RES_OK)
+        g_should_reset = true;
+    else
+        remove(THEME_NEW_PATH);
+
     mtx_unlock(&g_reset_mtx);
+
+    return res;
 }
 
 theme_t *curr_theme() {
     return &g_curr_theme;
+}
+
+theme_t *theme_use(ThemeLazy group) {
+    g_lazy_in_use[group] = true;
+
+    if (!g_lazy_loaded[group] && lazy_load(group) != LV_RES_OK)
+        LV_LOG_WARN("Couldn't load lazy theme assets");
+
+    return &g_curr_theme;
+}
+
+void theme_unuse(ThemeLazy group) {
+    g_lazy_in_use[group] = false;
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    if (mon.free_size < LAZY_EVICT_FREE_SIZE)
+        lazy_evict_unused();
 }
\ No newline at end of file
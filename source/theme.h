@@ -39,6 +39,7 @@
 typedef struct {
     void *buffer;
     size_t size;
+    lv_img_cf_t cf; // How an image asset is encoded
     const char *file_name;
 } asset_t;
 
@@ -79,6 +80,12 @@ typedef struct {
 
     lv_style_t warn_48_style;
 
+    lv_style_t icon_placeholder_style;
+
+    lv_style_t search_kb_bg_style;
+    lv_style_t search_kb_btn_rel_style;
+    lv_style_t search_kb_btn_pr_style;
+
     #ifdef MUSIC
 
     asset_t *intro_music;
@@ -87,9 +94,29 @@ typedef struct {
     #endif
 } theme_t;
 
+// Images only some screens show, their descriptors stay empty until asked for
+typedef enum {
+    ThemeLazy_dialog, // dialog_bg_dsc, dialog_btns_dscs
+    ThemeLazy_remote, // remote_progress_dsc
+    ThemeLazy_cursor, // cursor_dsc
+    ThemeLazy_max
+} ThemeLazy;
+
 lv_res_t theme_init();
 void theme_exit();
 
-void do_theme_reset();
+/*
+ * Returns the current theme with the group's descriptors loaded. If that
+ * fails they're left at 0x0 and draw nothing. Once the screen showing them
+ * goes away, theme_unuse lets them be freed when the LVGL heap runs low.
+ */
+theme_t *theme_use(ThemeLazy group);
+void theme_unuse(ThemeLazy group);
+
+/*
+ * Copies the theme zip at path in and resets the theme with it on the GUI
+ * thread. The copy only replaces theme.zip once the old theme is closed.
+ */
+lv_res_t theme_install(const char *path);
 
 theme_t *curr_theme();
\ No newline at end of file
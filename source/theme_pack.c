@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "theme_pack.h"
+
+lv_res_t theme_pack_open(theme_pack_t *pack, const char *path) {
+    pack->recs = NULL;
+    pack->count = 0;
+
+    pack->fp = fopen(path, "rb");
+    if (pack->fp == NULL)
+        return LV_RES_INV;
+
+    // The blobs are read whole, buffering them first would only add a copy
+    setvbuf(pack->fp, NULL, _IONBF, 0);
+
+    theme_pack_header_t header;
+    if (fread(&header, sizeof(header), 1, pack->fp) != 1 || header.magic != THEME_PACK_MAGIC || header.version != THEME_PACK_VERSION) {
+        theme_pack_close(pack);
+        return LV_RES_INV;
+    }
+
+    pack->recs = malloc(header.count * sizeof(theme_pack_rec_t));
+    if (pack->recs == NULL || fread(pack->recs, sizeof(theme_pack_rec_t), header.count, pack->fp) != header.count) {
+        theme_pack_close(pack);
+        return LV_RES_INV;
+    }
+
+    pack->count = header.count;
+
+    for (u32 i = 0; i < pack->count; i++)
+        pack->recs[i].name[THEME_PACK_NAME_LEN - 1] = '\0';
+
+    return LV_RES_OK;
+}
+
+void theme_pack_close(theme_pack_t *pack) {
+    free(pack->recs);
+
+    pack->recs = NULL;
+    pack->count = 0;
+
+    if (pack->fp != NULL) {
+        fclose(pack->fp);
+        pack->fp = NULL;
+    }
+}
+
+const theme_pack_rec_t *theme_pack_find(theme_pack_t *pack, const char *name) {
+    u32 lo = 0;
+    u32 hi = pack->count;
+
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+
+        int cmp = strcmp(pack->recs[mid].name, name);
+        if (cmp == 0)
+            return &pack->recs[mid];
+
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return NULL;
+}
+
+lv_res_t theme_pack_read(theme_pack_t *pack, const theme_pack_rec_t *rec, void *buf) {
+    if (rec->codec != ThemePackCodec_stored || rec->stored_size != rec->size)
+        return LV_RES_INV;
+
+    if (fseek(pack->fp, rec->offset, SEEK_SET) != 0)
+        return LV_RES_INV;
+
+    return (fread(buf, rec->size, 1, pack->fp) == 1 || rec->size == 0) ? LV_RES_OK : LV_RES_INV;
+}
\ No newline at end of file
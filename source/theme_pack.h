@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdio.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#define THEME_PACK_MAGIC 0x50434248 // "HBCP"
+#define THEME_PACK_VERSION 2
+
+#define THEME_PACK_NAME_LEN 44
+#define THEME_PACK_ALIGN 16
+
+typedef enum {
+    ThemePackCodec_stored,
+} ThemePackCodec;
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 count;
+    u32 reserved;
+} theme_pack_header_t;
+
+// Sorted by name, each blob starts on a THEME_PACK_ALIGN boundary
+typedef struct {
+    char name[THEME_PACK_NAME_LEN];
+    u32 offset;
+    u32 size;
+    u32 stored_size;
+    u32 codec;
+    u32 format; // The lv_img_cf_t of an image, LV_IMG_CF_UNKNOWN for anything else
+} theme_pack_rec_t;
+
+/*
+ * The native theme container written by tools/gen_theme.py: a header, the
+ * asset table and then the blobs, so an asset is a single read straight
+ * into its buffer instead of an inflate.
+ */
+typedef struct {
+    FILE *fp;
+
+    theme_pack_rec_t *recs;
+    u32 count;
+} theme_pack_t;
+
+lv_res_t theme_pack_open(theme_pack_t *pack, const char *path);
+void theme_pack_close(theme_pack_t *pack);
+
+const theme_pack_rec_t *theme_pack_find(theme_pack_t *pack, const char *name);
+
+// buf needs room for rec->size bytes
+lv_res_t theme_pack_read(theme_pack_t *pack, const theme_pack_rec_t *rec, void *buf);
\ No newline at end of file
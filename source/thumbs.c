@@ -0,0 +1,637 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "thumbs.h"
+#include "log.h"
+#include "util.h"
+
+#define THUMBS_TMP_PATH THUMBS_PATH ".tmp"
+
+#define THUMBS_TASK_PERIOD 1000
+#define THUMBS_COMPACT_MIN_FREE 16
+#define THUMBS_COMPACT_STEP 8 // Slots copied per task run, so compacting doesn't hold up the UI
+
+// Both files carry the generation, a data file that was compacted without the index catching up is thrown away
+typedef struct {
+    u32 magic;
+    u32 generation;
+    u64 reserved;
+} thumbs_data_header_t;
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 generation;
+    u32 count;
+    u32 num_slots;
+    u32 reserved;
+} thumbs_index_header_t;
+
+typedef struct {
+    u64 size;
+    s64 mtime;
+    u32 slot;
+    u16 path_len;
+    u16 reserved;
+} __attribute__((packed)) thumbs_disk_rec_t;
+
+typedef struct {
+    char *path;
+    u64 size;
+    s64 mtime;
+    u32 slot;
+    bool live;
+} thumb_rec_t;
+
+typedef struct {
+    u32 *slots;
+    size_t len;
+    size_t cap;
+} slot_list_t;
+
+static mtx_t g_mtx;
+static thumb_rec_t *g_recs = NULL;
+static size_t g_recs_cap = 0;
+static size_t g_recs_len = 0;
+
+static FILE *g_fp = NULL;
+static u32 g_generation = 0;
+static u32 g_num_slots = 0;
+static slot_list_t g_free = {0};
+static slot_list_t g_pending_free = {0}; // Still referenced by the index on the SD card, so not reused until it's saved
+static bool g_dirty = false;
+static lv_task_t *g_task = NULL;
+
+// Slots to copy in order while compacting, as indices into g_recs
+static size_t *g_compact_order = NULL;
+static size_t g_compact_len = 0;
+static size_t g_compact_pos = 0;
+static FILE *g_compact_fp = NULL;
+
+static lv_res_t slot_list_push(slot_list_t *list, u32 slot) {
+    if (list->len == list->cap) {
+        size_t new_cap = (list->cap == 0) ? 64 : list->cap * 2;
+
+        u32 *new_slots = realloc(list->slots, new_cap * sizeof(u32));
+        if (new_slots == NULL)
+            return LV_RES_INV;
+
+        list->slots = new_slots;
+        list->cap = new_cap;
+    }
+
+    list->slots[list->len++] = slot;
+
+    return LV_RES_OK;
+}
+
+static void slot_list_clear(slot_list_t *list) {
+    free(list->slots);
+
+    list->slots = NULL;
+    list->len = 0;
+    list->cap = 0;
+}
+
+static long slot_offset(u32 slot) {
+    return sizeof(thumbs_data_header_t) + (long) slot * THUMB_SIZE;
+}
+
+static thumb_rec_t *find_slot(const char *path) {
+    return hash_find_slot(g_recs, sizeof(thumb_rec_t), g_recs_cap, path, strlen(path), NULL);
+}
+
+static thumb_rec_t *find_rec(const char *path) {
+    if (g_recs_len == 0)
+        return NULL;
+
+    thumb_rec_t *rec = find_slot(path);
+
+    return (rec->path != NULL) ? rec : NULL;
+}
+
+static bool rec_is_live(const void *slot) {
+    return ((const thumb_rec_t *) slot)->live;
+}
+
+// Leaves out the records that aren't live and frees their slots
+static lv_res_t drop_dead() {
+    size_t len;
+
+    thumb_rec_t *new_recs = hash_rehash(g_recs, sizeof(thumb_rec_t), g_recs_cap, g_recs_cap, NULL, rec_is_live, &len);
+    if (new_recs == NULL)
+        return LV_RES_INV;
+
+    for (size_t i = 0; i < g_recs_cap; i++) {
+        if (g_recs[i].path != NULL && !g_recs[i].live) {
+            slot_list_push(&g_pending_free, g_recs[i].slot);
+            free(g_recs[i].path);
+        }
+    }
+
+    free(g_recs);
+    g_recs = new_recs;
+    g_recs_len = len;
+
+    return LV_RES_OK;
+}
+
+static thumb_rec_t *rec_ins(const char *path, size_t path_len) {
+    thumb_rec_t *recs = hash_grow(g_recs, sizeof(thumb_rec_t), &g_recs_cap, &g_recs_len, 256, NULL);
+    if (recs == NULL)
+        return NULL;
+
+    g_recs = recs;
+
+    char *tmp = malloc(path_len + 1);
+    if (tmp == NULL)
+        return NULL;
+
+    memcpy(tmp, path, path_len);
+    tmp[path_len] = '\0';
+
+    thumb_rec_t *rec = find_slot(tmp);
+    if (rec->path != NULL) {
+        free(rec->path);
+    } else {
+        g_recs_len++;
+    }
+
+    rec->path = tmp;
+
+    return rec;
+}
+
+static void clear_recs() {
+    for (size_t i = 0; i < g_recs_cap; i++)
+        free(g_recs[i].path);
+
+    free(g_recs);
+
+    g_recs = NULL;
+    g_recs_cap = 0;
+    g_recs_len = 0;
+}
+
+static lv_res_t load_index() {
+    FILE *fp = fopen(THUMBS_INDEX_PATH, "rb");
+    if (fp == NULL)
+        return LV_RES_INV;
+
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (file_size < (long) sizeof(thumbs_index_header_t)) {
+        fclose(fp);
+        return LV_RES_INV;
+    }
+
+    u8 *buf = malloc(file_size);
+    if (buf == NULL) {
+        fclose(fp);
+        return LV_RES_INV;
+    }
+
+    if (fread(buf, file_size, 1, fp) != 1) {
+        free(buf);
+        fclose(fp);
+        return LV_RES_INV;
+    }
+
+    fclose(fp);
+
+    thumbs_index_header_t *header = (thumbs_index_header_t *) buf;
+    if (header->magic != THUMBS_MAGIC || header->version != THUMBS_VERSION) {
+        free(buf);
+        return LV_RES_INV;
+    }
+
+    g_generation = header->generation;
+    g_num_slots = header->num_slots;
+
+    u8 *p = buf + sizeof(thumbs_index_header_t);
+    u8 *end = buf + file_size;
+
+    for (u32 i = 0; i < header->count; i++) {
+        thumbs_disk_rec_t disk_rec;
+        if (p + sizeof(disk_rec) > end)
+            break;
+
+        memcpy(&disk_rec, p, sizeof(disk_rec));
+        p += sizeof(disk_rec);
+
+        if (p + disk_rec.path_len > end || disk_rec.path_len == 0 || disk_rec.slot >= g_num_slots)
+            break;
+
+        thumb_rec_t *rec = rec_ins((char *) p, disk_rec.path_len);
+        if (rec == NULL)
+            break;
+
+        p += disk_rec.path_len;
+
+        rec->size = disk_rec.size;
+        rec->mtime = disk_rec.mtime;
+        rec->slot = disk_rec.slot;
+        rec->live = true;
+    }
+
+    free(buf);
+
+    return LV_RES_OK;
+}
+
+static lv_res_t write_index(FILE *fp, void *arg) {
+    thumbs_index_header_t header = {
+        .magic = THUMBS_MAGIC,
+        .version = THUMBS_VERSION,
+        .generation = g_generation,
+        .count = g_recs_len,
+        .num_slots = g_num_slots,
+    };
+
+    if (fwrite(&header, sizeof(header), 1, fp) != 1)
+        return LV_RES_INV;
+
+    for (size_t i = 0; i < g_recs_cap; i++) {
+        thumb_rec_t *rec = &g_recs[i];
+        if (rec->path == NULL)
+            continue;
+
+        thumbs_disk_rec_t disk_rec = {
+            .size = rec->size,
+            .mtime = rec->mtime,
+            .slot = rec->slot,
+            .path_len = strlen(rec->path),
+        };
+
+        if (fwrite(&disk_rec, sizeof(disk_rec), 1, fp) != 1 || fwrite(rec->path, disk_rec.path_len, 1, fp) != 1)
+            return LV_RES_INV;
+    }
+
+    return LV_RES_OK;
+}
+
+static lv_res_t save_index() {
+    if (save_file(THUMBS_INDEX_PATH, write_index, NULL) != LV_RES_OK)
+        return LV_RES_INV;
+
+    // Nothing on the SD card points at these anymore
+    for (size_t i = 0; i < g_pending_free.len; i++)
+        slot_list_push(&g_free, g_pending_free.slots[i]);
+
+    g_pending_free.len = 0;
+    g_dirty = false;
+
+    return LV_RES_OK;
+}
+
+static FILE *create_data_file(const char *path, u32 generation) {
+    FILE *fp = fopen(path, "w+b");
+    if (fp == NULL)
+        return NULL;
+
+    thumbs_data_header_t header = {
+        .magic = THUMBS_MAGIC,
+        .generation = generation,
+    };
+
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        fclose(fp);
+        remove(path);
+        return NULL;
+    }
+
+    return fp;
+}
+
+static lv_res_t open_data_file() {
+    g_fp = fopen(THUMBS_PATH, "r+b");
+
+    if (g_fp != NULL) {
+        thumbs_data_header_t header;
+        if (fread(&header, sizeof(header), 1, g_fp) == 1 && header.magic == THUMBS_MAGIC && header.generation == g_generation)
+            return LV_RES_OK;
+
+        fclose(g_fp);
+    }
+
+    // Whatever the index says doesn't match the data, so start over
+    clear_recs();
+
+    g_num_slots = 0;
+    g_fp = create_data_file(THUMBS_PATH, g_generation);
+
+    return (g_fp != NULL) ? LV_RES_OK : LV_RES_INV;
+}
+
+static void abort_compact() {
+    if (g_compact_fp == NULL)
+        return;
+
+    fclose(g_compact_fp);
+    remove(THUMBS_TMP_PATH);
+
+    free(g_compact_order);
+
+    g_compact_fp = NULL;
+    g_compact_order = NULL;
+    g_compact_len = 0;
+    g_compact_pos = 0;
+}
+
+static void start_compact(catalog_t *catalog) {
+    g_compact_order = malloc(g_recs_len * sizeof(size_t));
+    if (g_compact_order == NULL)
+        return;
+
+    // Catalog order, so a page of the list ends up in one run of slots
+    g_compact_len = 0;
+
+    for (int i = 0; i < catalog->len; i++) {
+        thumb_rec_t *rec = find_rec(catalog->entries[i]->path);
+
+        if (rec != NULL && rec->live && g_compact_len < g_recs_len) {
+            g_compact_order[g_compact_len++] = rec - g_recs;
+            rec->live = false; // The same path twice would get two slots otherwise
+        }
+    }
+
+    for (size_t i = 0; i < g_compact_len; i++)
+        g_recs[g_compact_order[i]].live = true;
+
+    g_compact_pos = 0;
+    g_compact_fp = create_data_file(THUMBS_TMP_PATH, g_generation + 1);
+
+    if (g_compact_fp == NULL) {
+        free(g_compact_order);
+        g_compact_order = NULL;
+        g_compact_len = 0;
+    }
+}
+
+static void finish_compact() {
+    if (fflush(g_compact_fp) != 0) {
+        abort_compact();
+        return;
+    }
+
+    fclose(g_compact_fp);
+    g_compact_fp = NULL;
+
+    fclose(g_fp);
+    g_fp = NULL;
+
+    if (replace_file(THUMBS_TMP_PATH, THUMBS_PATH) != LV_RES_OK) {
+        // The old slots are gone either way, so start from an empty file
+        clear_recs();
+        g_num_slots = 0;
+    } else {
+        g_generation++;
+
+        for (size_t i = 0; i < g_compact_len; i++)
+            g_recs[g_compact_order[i]].slot = i;
+
+        g_num_slots = g_compact_len;
+    }
+
+    free(g_compact_order);
+    g_compact_order = NULL;
+    g_compact_len = 0;
+    g_compact_pos = 0;
+
+    g_free.len = 0;
+    g_pending_free.len = 0;
+
+    if (open_data_file() == LV_RES_OK)
+        save_index();
+
+    logPrintf("thumbs: compacted to %u slots\n", g_num_slots);
+}
+
+static void compact_step() {
+    static u8 buf[THUMB_SIZE];
+
+    for (int i = 0; i < THUMBS_COMPACT_STEP && g_compact_pos < g_compact_len; i++, g_compact_pos++) {
+        thumb_rec_t *rec = &g_recs[g_compact_order[g_compact_pos]];
+
+        if (fseek(g_fp, slot_offset(rec->slot), SEEK_SET) != 0 || fread(buf, THUMB_SIZE, 1, g_fp) != 1 || fwrite(buf, THUMB_SIZE, 1, g_compact_fp) != 1) {
+            abort_compact();
+            return;
+        }
+    }
+
+    if (g_compact_pos == g_compact_len)
+        finish_compact();
+}
+
+static void thumbs_task(lv_task_t *task) {
+    mtx_lock(&g_mtx);
+
+    if (g_compact_fp != NULL)
+        compact_step();
+    else if (g_dirty)
+        save_index();
+
+    mtx_unlock(&g_mtx);
+}
+
+void thumbs_init() {
+    mtx_init(&g_mtx, mtx_plain);
+
+    if (load_index() != LV_RES_OK) {
+        clear_recs();
+        g_num_slots = 0;
+    }
+
+    if (open_data_file() != LV_RES_OK) {
+        LV_LOG_WARN("Thumbnails unavailable");
+        return;
+    }
+
+    g_task = lv_task_create(thumbs_task, THUMBS_TASK_PERIOD, LV_TASK_PRIO_LOWEST, NULL);
+}
+
+void thumbs_exit() {
+    if (g_task != NULL) {
+        lv_task_del(g_task);
+        g_task = NULL;
+    }
+
+    abort_compact();
+
+    if (g_fp != NULL) {
+        if (g_dirty)
+            save_index();
+
+        fclose(g_fp);
+        g_fp = NULL;
+    }
+
+    clear_recs();
+
+    slot_list_clear(&g_free);
+    slot_list_clear(&g_pending_free);
+
+    mtx_destroy(&g_mtx);
+}
+
+static u32 read_locked(app_entry_t **entries, u8 **out, int num) {
+    if (g_fp == NULL)
+        return 0;
+
+    struct {
+        u32 slot;
+        int idx;
+    } hits[num];
+    int num_hits = 0;
+
+    for (int i = 0; i < num && i < 32; i++) {
+        thumb_rec_t *rec = find_rec(entries[i]->path);
+        if (rec == NULL || rec->size != entries[i]->file_size || rec->mtime != entries[i]->file_mtime)
+            continue;
+
+        // Insertion sort by slot, there's a page worth at most
+        int j = num_hits++;
+        for (; j > 0 && hits[j - 1].slot > rec->slot; j--)
+            hits[j] = hits[j - 1];
+
+        hits[j].slot = rec->slot;
+        hits[j].idx = i;
+    }
+
+    u32 found = 0;
+
+    for (int run_start = 0; run_start < num_hits;) {
+        int run_len = 1;
+        while (run_start + run_len < num_hits && hits[run_start + run_len].slot == hits[run_start].slot + run_len)
+            run_len++;
+
+        if (fseek(g_fp, slot_offset(hits[run_start].slot), SEEK_SET) == 0) {
+            if (run_len == 1) {
+                if (fread(out[hits[run_start].idx], THUMB_SIZE, 1, g_fp) == 1)
+                    found |= BIT(hits[run_start].idx);
+            } else {
+                u8 *buf = malloc(run_len * THUMB_SIZE);
+
+                if (buf != NULL && fread(buf, THUMB_SIZE, run_len, g_fp) == run_len) {
+                    for (int i = 0; i < run_len; i++) {
+                        memcpy(out[hits[run_start + i].idx], buf + i * THUMB_SIZE, THUMB_SIZE);
+                        found |= BIT(hits[run_start + i].idx);
+                    }
+                }
+
+                free(buf);
+            }
+        }
+
+        run_start += run_len;
+    }
+
+    return found;
+}
+
+static void write_locked(app_entry_t *entry, const u8 *data) {
+    if (g_fp == NULL)
+        return;
+
+    // Slot numbers are about to change under it
+    abort_compact();
+
+    thumb_rec_t *rec = find_rec(entry->path);
+    u32 slot;
+
+    if (rec != NULL) {
+        // Rewriting the same path in place is fine, the old index on the SD card won't match its mtime
+        slot = rec->slot;
+    } else if (g_free.len > 0) {
+        slot = g_free.slots[--g_free.len];
+    } else {
+        slot = g_num_slots;
+    }
+
+    if (fseek(g_fp, slot_offset(slot), SEEK_SET) != 0 || fwrite(data, THUMB_SIZE, 1, g_fp) != 1 || fflush(g_fp) != 0) {
+        if (rec == NULL && slot != g_num_slots)
+            slot_list_push(&g_free, slot);
+
+        return;
+    }
+
+    if (rec == NULL) {
+        rec = rec_ins(entry->path, strlen(entry->path));
+        if (rec == NULL) {
+            if (slot != g_num_slots)
+                slot_list_push(&g_free, slot);
+
+            return;
+        }
+    }
+
+    if (slot == g_num_slots)
+        g_num_slots++;
+
+    rec->size = entry->file_size;
+    rec->mtime = entry->file_mtime;
+    rec->slot = slot;
+    rec->live = true;
+
+    g_dirty = true;
+}
+
+static void reclaim_locked(catalog_t *catalog) {
+    if (g_fp == NULL)
+        return;
+
+    abort_compact();
+
+    for (size_t i = 0; i < g_recs_cap; i++)
+        g_recs[i].live = false;
+
+    for (int i = 0; i < catalog->len; i++) {
+        app_entry_t *entry = catalog->entries[i];
+        thumb_rec_t *rec = find_rec(entry->path);
+
+        if (rec != NULL && rec->size == entry->file_size && rec->mtime == entry->file_mtime)
+            rec->live = true;
+    }
+
+    size_t old_len = g_recs_len;
+
+    if (g_recs_cap > 0 && drop_dead() != LV_RES_OK)
+        return;
+
+    size_t num_dead = old_len - g_recs_len;
+    if (num_dead > 0)
+        g_dirty = true;
+
+    size_t num_free = g_free.len + g_pending_free.len;
+
+    logPrintf("thumbs: %zu live, %zu reclaimed, %zu of %u slots free\n", g_recs_len, num_dead, num_free, g_num_slots);
+
+    if (num_free >= THUMBS_COMPACT_MIN_FREE && num_free * 4 >= g_num_slots)
+        start_compact(catalog);
+}
+
+u32 thumbs_read(app_entry_t **entries, u8 **out, int num) {
+    mtx_lock(&g_mtx);
+    u32 found = read_locked(entries, out, num);
+    mtx_unlock(&g_mtx);
+
+    return found;
+}
+
+void thumbs_write(app_entry_t *entry, const u8 *data) {
+    mtx_lock(&g_mtx);
+    write_locked(entry, data);
+    mtx_unlock(&g_mtx);
+}
+
+void thumbs_reclaim(catalog_t *catalog) {
+    mtx_lock(&g_mtx);
+    reclaim_locked(catalog);
+    mtx_unlock(&g_mtx);
+}
\ No newline at end of file
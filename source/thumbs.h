@@ -0,0 +1,42 @@
+#pragma once
+
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "apps.h"
+#include "catalog.h"
+#include "settings.h"
+
+#define THUMBS_PATH SETTINGS_DIR "/thumbs.bin"
+#define THUMBS_INDEX_PATH SETTINGS_DIR "/thumbs.idx"
+
+#define THUMBS_MAGIC 0x54434248 // "HBCT"
+#define THUMBS_VERSION 1
+
+#define THUMB_W APP_ICON_SMALL_W
+#define THUMB_H APP_ICON_SMALL_H
+#define THUMB_SIZE (THUMB_W * THUMB_H * sizeof(lv_color_t))
+
+/*
+ * Decoded small icons, kept on the SD card in fixed size slots so a
+ * page of them is a read or two instead of a JPEG decode each. Records
+ * are keyed by path and only good while the size and mtime match.
+ * Reads and writes may come from any thread.
+ */
+void thumbs_init();
+void thumbs_exit();
+
+/*
+ * Fills out[i] with the thumbnail of entries[i], each needs room for
+ * THUMB_SIZE bytes. Slots that sit next to each other in the file are
+ * read together. Returns a bit mask of the entries that were found.
+ */
+u32 thumbs_read(app_entry_t **entries, u8 **out, int num);
+void thumbs_write(app_entry_t *entry, const u8 *data);
+
+/*
+ * Frees the slots of anything that isn't in the catalog anymore, call
+ * it only with the result of a full scan. The file gets compacted in
+ * catalog order by a task afterwards if too much of it is free.
+ */
+void thumbs_reclaim(catalog_t *catalog);
\ No newline at end of file
@@ -33,6 +33,75 @@ char *get_name(char *path) {
     return p + 1;
 }
 
+u32 hash_bytes(const void *data, size_t len) {
+    const u8 *bytes = data;
+    u32 hash = 2166136261u; // FNV-1a
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+void *hash_find_slot(void *slots, size_t slot_size, size_t cap, const char *key, size_t len, const char *tombstone) {
+    size_t i = hash_bytes(key, len) & (cap - 1);
+    u8 *reuse = NULL;
+
+    for (;; i = (i + 1) & (cap - 1)) {
+        u8 *slot = (u8 *) slots + i * slot_size;
+        const char *slot_key = *(const char **) slot;
+
+        if (slot_key == NULL)
+            return (reuse != NULL) ? reuse : slot;
+
+        if (slot_key == tombstone) {
+            if (reuse == NULL)
+                reuse = slot;
+        } else if (strncmp(slot_key, key, len) == 0 && slot_key[len] == '\0') {
+            return slot;
+        }
+    }
+}
+
+void *hash_rehash(const void *slots, size_t slot_size, size_t cap, size_t new_cap, const char *tombstone, hash_keep_t keep, size_t *len) {
+    u8 *new_slots = calloc(new_cap, slot_size);
+    if (new_slots == NULL)
+        return NULL;
+
+    *len = 0;
+
+    for (size_t i = 0; i < cap; i++) {
+        const u8 *slot = (const u8 *) slots + i * slot_size;
+        const char *key = *(const char * const *) slot;
+
+        if (key == NULL || key == tombstone || (keep != NULL && !keep(slot)))
+            continue;
+
+        memcpy(hash_find_slot(new_slots, slot_size, new_cap, key, strlen(key), NULL), slot, slot_size);
+        (*len)++;
+    }
+
+    return new_slots;
+}
+
+void *hash_grow(void *slots, size_t slot_size, size_t *cap, size_t *used, size_t min_cap, const char *tombstone) {
+    if ((*used + 1) * 2 <= *cap)
+        return slots;
+
+    size_t new_cap = (*cap == 0) ? min_cap : *cap * 2;
+
+    void *new_slots = hash_rehash(slots, slot_size, *cap, new_cap, tombstone, NULL, used);
+    if (new_slots == NULL)
+        return NULL;
+
+    free(slots);
+    *cap = new_cap;
+
+    return new_slots;
+}
+
 int mkdirs(char *path, mode_t mode) {
     char tmp_dir[PATH_MAX + 1];
     tmp_dir[0] = '\0';
@@ -82,4 +151,31 @@ lv_res_t copy(char *dest, char *from) {
     fclose(frm);
 
     return LV_RES_OK;
+}
+
+lv_res_t replace_file(const char *from, const char *path) {
+    remove(path);
+
+    return (rename(from, path) == 0) ? LV_RES_OK : LV_RES_INV;
+}
+
+lv_res_t save_file(const char *path, lv_res_t (*write)(FILE *fp, void *arg), void *arg) {
+    char tmp_path[PATH_MAX + 1];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL)
+        return LV_RES_INV;
+
+    lv_res_t res = write(fp, arg);
+
+    if (fclose(fp) != 0)
+        res = LV_RES_INV;
+
+    if (res != LV_RES_OK) {
+        remove(tmp_path);
+        return LV_RES_INV;
+    }
+
+    return replace_file(tmp_path, path);
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <stdio.h>
 #include <sys/types.h>
 #include <lvgl/lvgl.h>
+#include <switch.h>
 
 bool is_dir(char *path);
 bool is_file(char *path);
@@ -9,6 +11,41 @@ bool is_file(char *path);
 char *get_ext(char *str);
 char *get_name(char *path);
 
+u32 hash_bytes(const void *data, size_t len);
+
+/*
+ * Open addressing with linear probing, for tables keyed by string. Every
+ * slot starts with its key, a char pointer that's NULL while the slot is
+ * empty, and cap is a power of two. Tables that remove keys put their
+ * tombstone pointer in the slot so lookups go on past it, the others pass
+ * NULL.
+ *
+ * Returns the slot holding key, otherwise the first one it could go in.
+ */
+void *hash_find_slot(void *slots, size_t slot_size, size_t cap, const char *key, size_t len, const char *tombstone);
+
+typedef bool (*hash_keep_t)(const void *slot);
+
+// A new table of new_cap with the keys, leaving out tombstones and what keep turns down. slots is left as it was
+void *hash_rehash(const void *slots, size_t slot_size, size_t cap, size_t new_cap, const char *tombstone, hash_keep_t keep, size_t *len);
+
+/*
+ * Keeps a table at most half full with one more key in it, by moving it to
+ * one twice the size, or min_cap to begin with. Returns slots or the table
+ * that replaced it, NULL if that couldn't be allocated. used counts
+ * tombstones too and drops them when the table moves.
+ */
+void *hash_grow(void *slots, size_t slot_size, size_t *cap, size_t *used, size_t min_cap, const char *tombstone);
+
 int mkdirs(char *path, mode_t mode);
 
-lv_res_t copy(char *dest, char *from);
\ No newline at end of file
+lv_res_t copy(char *dest, char *from);
+
+// Puts from in place of path, whether or not path is there already
+lv_res_t replace_file(const char *from, const char *path);
+
+/*
+ * Writes path through path.tmp, which only replaces it once write has
+ * succeeded, so a failure halfway through leaves the old file be.
+ */
+lv_res_t save_file(const char *path, lv_res_t (*write)(FILE *fp, void *arg), void *arg);
\ No newline at end of file
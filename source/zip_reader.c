@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <string.h>
+#include <minizip/unzip.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#include "zip_reader.h"
+#include "util.h"
+
+static zip_member_t *find_slot(zip_reader_t *zip, const char *name) {
+    return hash_find_slot(zip->members, sizeof(zip_member_t), zip->cap, name, strlen(name), NULL);
+}
+
+static lv_res_t build_index(zip_reader_t *zip) {
+    unz_global_info global_info;
+    if (unzGetGlobalInfo(zip->zf, &global_info) != UNZ_OK)
+        return LV_RES_INV;
+
+    // At most half full, so a lookup hardly ever probes more than a slot or two
+    zip->cap = 16;
+    while (zip->cap < global_info.number_entry * 2)
+        zip->cap *= 2;
+
+    zip->members = calloc(zip->cap, sizeof(zip_member_t));
+    if (zip->members == NULL)
+        return LV_RES_INV;
+
+    int ret = unzGoToFirstFile(zip->zf);
+
+    for (u32 i = 0; ret == UNZ_OK && i < global_info.number_entry; i++, ret = unzGoToNextFile(zip->zf)) {
+        char name[ZIP_READER_MAX_NAME];
+        unz_file_info file_info;
+
+        if (unzGetCurrentFileInfo(zip->zf, &file_info, name, sizeof(name), NULL, 0, NULL, 0) != UNZ_OK)
+            return LV_RES_INV;
+
+        // It would only ever be found under its truncated name
+        if (file_info.size_filename >= sizeof(name))
+            continue;
+
+        zip_member_t *member = find_slot(zip, name);
+        if (member->name != NULL)
+            continue;
+
+        member->name = strdup(name);
+        if (member->name == NULL)
+            return LV_RES_INV;
+
+        member->size = file_info.uncompressed_size;
+        member->method = file_info.compression_method;
+
+        if (unzGetFilePos(zip->zf, &member->pos) != UNZ_OK)
+            return LV_RES_INV;
+    }
+
+    return (ret == UNZ_OK || ret == UNZ_END_OF_LIST_OF_FILE) ? LV_RES_OK : LV_RES_INV;
+}
+
+lv_res_t zip_reader_open(zip_reader_t *zip, const char *path, bool index) {
+    zip->members = NULL;
+    zip->cap = 0;
+
+    zip->zf = unzOpen(path);
+    if (zip->zf == NULL)
+        return LV_RES_INV;
+
+    if (index && build_index(zip) != LV_RES_OK) {
+        zip_reader_close(zip);
+        return LV_RES_INV;
+    }
+
+    return LV_RES_OK;
+}
+
+void zip_reader_close(zip_reader_t *zip) {
+    for (u32 i = 0; i < zip->cap; i++)
+        free(zip->members[i].name);
+
+    free(zip->members);
+
+    zip->members = NULL;
+    zip->cap = 0;
+
+    if (zip->zf != NULL) {
+        unzClose(zip->zf);
+        zip->zf = NULL;
+    }
+}
+
+const zip_member_t *zip_reader_find(zip_reader_t *zip, const char *name) {
+    if (zip->cap == 0)
+        return NULL;
+
+    zip_member_t *member = find_slot(zip, name);
+
+    return (member->name != NULL) ? member : NULL;
+}
+
+lv_res_t zip_reader_read(zip_reader_t *zip, const zip_member_t *member, void *buf) {
+    unz_file_pos pos = member->pos;
+
+    if (unzGoToFilePos(zip->zf, &pos) != UNZ_OK || unzOpenCurrentFile(zip->zf) != UNZ_OK)
+        return LV_RES_INV;
+
+    int read = unzReadCurrentFile(zip->zf, buf, member->size);
+
+    unzCloseCurrentFile(zip->zf);
+
+    return (read >= 0 && (u32) read == member->size) ? LV_RES_OK : LV_RES_INV;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <minizip/unzip.h>
+#include <lvgl/lvgl.h>
+#include <switch.h>
+
+#define ZIP_READER_MAX_NAME 256
+
+typedef struct {
+    char *name; // NULL for an empty slot
+    unz_file_pos pos; // Of the central directory record, so minizip can go straight to it
+    u32 size; // Uncompressed
+    u32 method;
+} zip_member_t;
+
+/*
+ * A zip opened once with its central directory read into a hash table,
+ * so finding a member doesn't scan the whole directory every time.
+ */
+typedef struct {
+    unzFile zf;
+
+    zip_member_t *members;
+    u32 cap;
+} zip_reader_t;
+
+/*
+ * Without the index only members whose position is already known, say
+ * from an earlier zip_reader_find, can be read.
+ */
+lv_res_t zip_reader_open(zip_reader_t *zip, const char *path, bool index);
+void zip_reader_close(zip_reader_t *zip);
+
+const zip_member_t *zip_reader_find(zip_reader_t *zip, const char *name);
+
+// buf needs room for member->size bytes
+lv_res_t zip_reader_read(zip_reader_t *zip, const zip_member_t *member, void *buf);
\ No newline at end of file
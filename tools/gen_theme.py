@@ -2,21 +2,188 @@
 
 import sys
 import os
+import struct
 import zipfile
 from PIL import Image
 from pathlib import Path
 
-def add_asset_to_theme(zf, path, new_path):
+# Layout of the .hbctheme pack, see source/theme_pack.h
+PACK_MAGIC = 0x50434248
+PACK_VERSION = 2
+PACK_NAME_LEN = 44
+PACK_ALIGN = 16
+PACK_CODEC_STORED = 0
+
+# lv_img_cf_t values
+CF_UNKNOWN = 0
+CF_RAW_ALPHA = 2
+CF_TRUE_COLOR_ALPHA = 5
+CF_INDEXED_1BIT = 7
+
+# Run length encoding read by the decoder, see rle_read_line in source/decoder.c
+RLE_MAGIC = 0x454c5248
+RLE_MAX_RUN = 128
+
+# LVGL draws palette images chroma keyed with LV_COLOR_TRANSP, so that's what transparent pixels turn into
+CHROMA_KEY = b"\x00\xff\x00"
+
+# An encoding that doesn't save at least this much isn't worth decoding while drawing
+MIN_SAVING = 0.25
+
+# Read straight from their pixels rather than drawn through a decoder (lv_canvas_rotate), so always plain BGRA
+RAW_ONLY = {"cursor.bin"}
+
+def asset_to_bgra(path):
     im = Image.open(path).convert("RGBA")
 
     # Convert to BGRA
     r, g, b, a = im.split()
     im = Image.merge("RGBA", (b, g, r, a))
 
-    zf.writestr(new_path, im.tobytes())
+    return im.tobytes(), im.size
+
+def encode_indexed(data, w, h):
+    palette = {}
+    indices = []
+
+    for i in range(0, len(data), 4):
+        bgr, a = data[i:i + 3], data[i + 3]
+
+        # Palette images have no alpha, only fully transparent or opaque pixels survive the trip
+        if a == 0:
+            bgr = CHROMA_KEY
+        elif a != 255 or bgr == CHROMA_KEY:
+            return None
+
+        if bgr not in palette:
+            if len(palette) == 256:
+                return None
+
+            palette[bgr] = len(palette)
+
+        indices.append(palette[bgr])
+
+    bpp = next(bpp for bpp in (1, 2, 4, 8) if len(palette) <= 1 << bpp)
+
+    out = bytearray()
+    for bgr in palette:
+        out += bgr + b"\xff"
+
+    out += bytes(((1 << bpp) - len(palette)) * 4)
+
+    # Rows start on a byte, highest bits first
+    for y in range(h):
+        byte = 0
+        bits = 0
+
+        for x in range(w):
+            byte = (byte << bpp) | indices[y * w + x]
+            bits += bpp
+
+            if bits == 8:
+                out.append(byte)
+                byte = 0
+                bits = 0
+
+        if bits > 0:
+            out.append(byte << (8 - bits))
+
+    return CF_INDEXED_1BIT + (1, 2, 4, 8).index(bpp), bytes(out)
+
+def encode_rle(data, w, h):
+    rows = []
+
+    for y in range(h):
+        px = [data[(y * w + x) * 4:(y * w + x + 1) * 4] for x in range(w)]
+        row = bytearray()
+        x = 0
+
+        while x < w:
+            run = 1
+            while x + run < w and run < RLE_MAX_RUN and px[x + run] == px[x]:
+                run += 1
+
+            if run > 1:
+                row.append(0x80 | (run - 1))
+                row += px[x]
+                x += run
+                continue
+
+            # Literals up to where the next repeat starts
+            start = x
+            x += 1
+            while x < w and x - start < RLE_MAX_RUN and not (x + 1 < w and px[x] == px[x + 1]):
+                x += 1
+
+            row.append(x - start - 1)
+            row += b"".join(px[start:x])
+
+        rows.append(bytes(row))
+
+    out = bytearray(struct.pack("<I2HI", RLE_MAGIC, w, h, 0))
+
+    offset = len(out) + h * 4
+    for row in rows:
+        out += struct.pack("<I", offset)
+        offset += len(row)
+
+    for row in rows:
+        out += row
+
+    return CF_RAW_ALPHA, bytes(out)
+
+# The smallest of plain BGRA, a palette or run length encoding
+def encode_image(data, size):
+    w, h = size
+
+    best = (CF_TRUE_COLOR_ALPHA, data)
+
+    for encoded in (encode_indexed(data, w, h), encode_rle(data, w, h)):
+        if encoded is not None and len(encoded[1]) < len(best[1]):
+            best = encoded
+
+    if len(best[1]) > len(data) * (1 - MIN_SAVING):
+        best = (CF_TRUE_COLOR_ALPHA, data)
+
+    return best
+
+def align(n):
+    return (n + PACK_ALIGN - 1) & ~(PACK_ALIGN - 1)
+
+def write_pack(theme_path, files, image_sizes):
+    names = sorted(files, key=lambda name: name.encode())
+
+    header = struct.pack("<4I", PACK_MAGIC, PACK_VERSION, len(names), 0)
+    recs = b""
+    blobs = b""
+
+    offset = align(len(header) + len(names) * (PACK_NAME_LEN + 20))
+
+    for name in names:
+        name_bytes = name.encode()
+        if len(name_bytes) >= PACK_NAME_LEN:
+            raise ValueError(f"{name} is too long for a theme pack")
+
+        data = files[name]
+        cf = CF_UNKNOWN
+
+        if name in RAW_ONLY:
+            cf = CF_TRUE_COLOR_ALPHA
+        elif name in image_sizes:
+            cf, data = encode_image(data, image_sizes[name])
+            print(f"{name}: {len(data)} of {len(files[name])} bytes as format {cf}")
+
+        recs += struct.pack(f"<{PACK_NAME_LEN}s5I", name_bytes, offset + len(blobs), len(data), len(data), PACK_CODEC_STORED, cf)
+        blobs += data + bytes(align(len(data)) - len(data))
+
+    with theme_path.open("wb") as f:
+        f.write(header)
+        f.write(recs)
+        f.write(bytes(offset - len(header) - len(recs)))
+        f.write(blobs)
 
 def main(argv):
-    usage = "Usage: gen_theme.py <resources folder> <output theme.zip> [ignore extension...]"
+    usage = "Usage: gen_theme.py <resources folder> <output theme.zip or theme.hbctheme> [ignore extension...]"
 
     if len(argv) < 2:
         print(usage)
@@ -33,15 +200,24 @@ def main(argv):
 
     ignore_exts = argv[2:]
 
-    with zipfile.ZipFile(theme_path, "w", zipfile.ZIP_DEFLATED) as zf:
-        for p in res_dir.iterdir():
-            if p.suffix in ignore_exts:
-                continue
-            elif p.suffix == ".png":
-                add_asset_to_theme(zf, p, f"{p.stem}.bin")
-            else:
-                with p.open("rb") as f:
-                    zf.writestr(p.name, f.read())
+    files = {}
+    image_sizes = {}
+
+    for p in res_dir.iterdir():
+        if p.suffix in ignore_exts:
+            continue
+        elif p.suffix == ".png":
+            files[f"{p.stem}.bin"], image_sizes[f"{p.stem}.bin"] = asset_to_bgra(p)
+        else:
+            with p.open("rb") as f:
+                files[p.name] = f.read()
+
+    if theme_path.suffix == ".hbctheme":
+        write_pack(theme_path, files, image_sizes)
+    else:
+        with zipfile.ZipFile(theme_path, "w", zipfile.ZIP_DEFLATED) as zf:
+            for name, data in files.items():
+                zf.writestr(name, data)
 
     return 0
 